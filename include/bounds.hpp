@@ -0,0 +1,132 @@
+/**
+ * @file bounds.hpp
+ *
+ * @brief Bounding volumes, and frustum intersection tests.
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2011 Olivier Favre
+ *
+ * This file is part of Breach.
+ *
+ * Licensed under the Simplified BSD License,
+ * for details please see LICENSE file or the website
+ * http://www.opensource.org/licenses/BSD-2-Clause
+ */
+
+#ifndef _BOUNDS_HPP
+#define _BOUNDS_HPP 1
+
+#include "matrix.hpp"
+
+
+
+/**
+ * @brief Spatial extent of an object, as both an axis-aligned bounding box and a bounding sphere.
+ *
+ * The sphere gives a cheap first test, and the box a tighter second one.
+ * A volume may also be empty (nothing to draw), or infinite (unknown extent, never culled).
+ *
+ * Points follow the "fourth component is 1" convention.
+ */
+class BoundingVolume {
+    private:
+        //! @brief Minimum corner of the box.
+        Matrix<float,4,1> minimum;
+        //! @brief Maximum corner of the box.
+        Matrix<float,4,1> maximum;
+        //! @brief Center of the sphere.
+        Matrix<float,4,1> center;
+        //! @brief Radius of the sphere, negative if the volume is empty.
+        float radius;
+        //! @brief Whether the volume is infinite.
+        bool infinite;
+
+        //! @brief Sets the sphere to the one circumscribing the box.
+        void circumscribeBox();
+
+    public:
+        //! @brief Constructs an empty volume.
+        BoundingVolume();
+        /**
+         * @brief Constructs the volume of a box.
+         *
+         * @param minimum Minimum corner
+         * @param maximum Maximum corner
+         */
+        BoundingVolume(const Matrix<float,4,1>& minimum, const Matrix<float,4,1>& maximum);
+        //! @brief Returns an infinite volume.
+        static BoundingVolume everything();
+
+        //! @brief Whether the volume contains nothing.
+        bool isEmpty() const;
+        //! @brief Whether the volume is infinite.
+        bool isInfinite() const;
+        //! @brief Returns the minimum corner of the box.
+        const Matrix<float,4,1>& getMinimum() const;
+        //! @brief Returns the maximum corner of the box.
+        const Matrix<float,4,1>& getMaximum() const;
+        //! @brief Returns the center of the sphere.
+        const Matrix<float,4,1>& getCenter() const;
+        //! @brief Returns the radius of the sphere.
+        float getRadius() const;
+
+        /**
+         * @brief Grows the volume to enclose another one.
+         *
+         * The box becomes the union of both boxes.
+         * The sphere becomes the smallest one enclosing both spheres,
+         * unless the sphere circumscribing the new box is smaller.
+         */
+        void merge(const BoundingVolume& other);
+        /**
+         * @brief Returns the volume enclosing this one, once transformed.
+         *
+         * @param transformation An affine transformation
+         */
+        BoundingVolume transform(const Matrix<float,4,4>& transformation) const;
+};
+
+
+
+/**
+ * @brief Truncated pyramid of the visible space, given as six planes.
+ *
+ * The planes are extracted from a clip matrix (projection, multiplied by the modelview matrix),
+ * so that the frustum is expressed in the coordinates the modelview matrix transforms from.
+ */
+class Frustum {
+    public:
+        //! @brief Result of an intersection test.
+        enum Intersection {
+            //! @brief Completely outside of the frustum.
+            OUTSIDE,
+            //! @brief Possibly partly inside of the frustum.
+            INTERSECTING,
+            //! @brief Completely inside of the frustum.
+            INSIDE
+        };
+
+    private:
+        //! @brief Normalized left, right, bottom, top, near and far planes \f$ (a, b, c, d) \f$, where \f$ a x + b y + c z + d \geq 0 \f$ inside.
+        float planes[6][4];
+
+    public:
+        //! @brief Constructs the frustum of the identity clip matrix, a cube between -1 and +1.
+        Frustum();
+        /**
+         * @brief Extracts the frustum of a clip matrix.
+         *
+         * @param clip The projection matrix, multiplied by the modelview matrix
+         */
+        explicit Frustum(const Matrix<float,4,4>& clip);
+
+        //! @brief Tests a bounding volume, first with its sphere, then with its box if still undecided.
+        Intersection classify(const BoundingVolume& volume) const;
+};
+
+
+
+#include "bounds.tcc"
+
+#endif /* _BOUNDS_HPP */
@@ -0,0 +1,228 @@
+/**
+ * @file bounds.tcc
+ *
+ * @brief Bounding volumes, and frustum intersection tests, inline code.
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2011 Olivier Favre
+ *
+ * This file is part of Breach.
+ *
+ * Licensed under the Simplified BSD License,
+ * for details please see LICENSE file or the website
+ * http://www.opensource.org/licenses/BSD-2-Clause
+ */
+
+#ifndef _BOUNDS_HPP
+#error You should include bounds.hpp instead of this file directly
+#endif
+
+#ifndef _BOUNDS_TCC
+#define _BOUNDS_TCC 1
+
+#include <cmath>
+#include <algorithm>
+
+
+
+inline BoundingVolume::BoundingVolume()
+: minimum(0, 0, 0, 1)
+, maximum(0, 0, 0, 1)
+, center(0, 0, 0, 1)
+, radius(-1)
+, infinite(false)
+{
+}
+
+inline BoundingVolume::BoundingVolume(const Matrix<float,4,1>& minimum, const Matrix<float,4,1>& maximum)
+: minimum(minimum)
+, maximum(maximum)
+, infinite(false)
+{
+    circumscribeBox();
+}
+
+inline BoundingVolume BoundingVolume::everything()
+{
+    BoundingVolume rtn;
+    rtn.infinite = true;
+    return rtn;
+}
+
+inline void BoundingVolume::circumscribeBox()
+{
+    float squaredRadius = 0;
+    for (unsigned int i = 0 ; i < 3 ; i++) {
+        center[i] = (minimum[i] + maximum[i]) / 2;
+        squaredRadius += (maximum[i] - center[i]) * (maximum[i] - center[i]);
+    }
+    center[3] = 1;
+    radius = std::sqrt(squaredRadius);
+}
+
+inline bool BoundingVolume::isEmpty() const
+{
+    return !infinite && radius < 0;
+}
+
+inline bool BoundingVolume::isInfinite() const
+{
+    return infinite;
+}
+
+inline const Matrix<float,4,1>& BoundingVolume::getMinimum() const
+{
+    return minimum;
+}
+
+inline const Matrix<float,4,1>& BoundingVolume::getMaximum() const
+{
+    return maximum;
+}
+
+inline const Matrix<float,4,1>& BoundingVolume::getCenter() const
+{
+    return center;
+}
+
+inline float BoundingVolume::getRadius() const
+{
+    return radius;
+}
+
+inline void BoundingVolume::merge(const BoundingVolume& other)
+{
+    if (infinite || other.isEmpty()) return;
+    if (other.infinite || isEmpty()) {
+        *this = other;
+        return;
+    }
+
+    // Smallest sphere enclosing both spheres
+    float distance = 0;
+    for (unsigned int i = 0 ; i < 3 ; i++)
+        distance += (other.center[i] - center[i]) * (other.center[i] - center[i]);
+    distance = std::sqrt(distance);
+    Matrix<float,4,1> mergedCenter = center;
+    float mergedRadius = radius;
+    if (distance + other.radius <= radius) {
+        // The other sphere is already enclosed
+    } else if (distance + radius <= other.radius) {
+        mergedCenter = other.center;
+        mergedRadius = other.radius;
+    } else {
+        mergedRadius = (distance + radius + other.radius) / 2;
+        float ratio = (mergedRadius - radius) / distance;
+        for (unsigned int i = 0 ; i < 3 ; i++)
+            mergedCenter[i] = center[i] + (other.center[i] - center[i]) * ratio;
+    }
+
+    for (unsigned int i = 0 ; i < 3 ; i++) {
+        minimum[i] = std::min(minimum[i], other.minimum[i]);
+        maximum[i] = std::max(maximum[i], other.maximum[i]);
+    }
+    circumscribeBox();
+    if (mergedRadius < radius) {
+        center = mergedCenter;
+        radius = mergedRadius;
+    }
+}
+
+inline BoundingVolume BoundingVolume::transform(const Matrix<float,4,4>& transformation) const
+{
+    if (infinite || isEmpty()) return *this;
+    BoundingVolume rtn;
+    rtn.infinite = false;
+
+    // Box: transform the center, and accumulate the absolute contribution of each half extent
+    float maximumScale = 0;
+    for (unsigned int l = 0 ; l < 3 ; l++) {
+        float boxCenter = transformation(l,3);
+        float halfExtent = 0;
+        for (unsigned int c = 0 ; c < 3 ; c++) {
+            boxCenter += transformation(l,c) * (minimum[c] + maximum[c]) / 2;
+            halfExtent += std::fabs(transformation(l,c)) * (maximum[c] - minimum[c]) / 2;
+        }
+        rtn.minimum[l] = boxCenter - halfExtent;
+        rtn.maximum[l] = boxCenter + halfExtent;
+    }
+
+    // Sphere: transform the center, and scale the radius by the largest axis scaling
+    for (unsigned int c = 0 ; c < 3 ; c++) {
+        float squaredScale = 0;
+        for (unsigned int l = 0 ; l < 3 ; l++)
+            squaredScale += transformation(l,c) * transformation(l,c);
+        maximumScale = std::max(maximumScale, squaredScale);
+    }
+    for (unsigned int l = 0 ; l < 3 ; l++) {
+        rtn.center[l] = transformation(l,3);
+        for (unsigned int c = 0 ; c < 3 ; c++)
+            rtn.center[l] += transformation(l,c) * center[c];
+    }
+    rtn.radius = radius * std::sqrt(maximumScale);
+
+    // Keep the smallest sphere
+    BoundingVolume circumscribed (rtn.minimum, rtn.maximum);
+    if (circumscribed.radius < rtn.radius) {
+        rtn.center = circumscribed.center;
+        rtn.radius = circumscribed.radius;
+    }
+    return rtn;
+}
+
+
+
+inline Frustum::Frustum()
+: Frustum(MatrixHelper::identity<float>())
+{
+}
+
+inline Frustum::Frustum(const Matrix<float,4,4>& clip)
+{
+    // Each plane is the last row of the clip matrix, plus or minus one of the other rows
+    for (unsigned int p = 0 ; p < 6 ; p++) {
+        unsigned int row = p / 2;
+        float sign = p % 2 == 0 ? 1 : -1;
+        for (unsigned int c = 0 ; c < 4 ; c++)
+            planes[p][c] = clip(3,c) + sign * clip(row,c);
+        float norm = std::sqrt(planes[p][0] * planes[p][0] + planes[p][1] * planes[p][1] + planes[p][2] * planes[p][2]);
+        for (unsigned int c = 0 ; c < 4 ; c++)
+            planes[p][c] /= norm;
+    }
+}
+
+inline Frustum::Intersection Frustum::classify(const BoundingVolume& volume) const
+{
+    if (volume.isInfinite()) return INTERSECTING;
+    if (volume.isEmpty()) return OUTSIDE;
+
+    const Matrix<float,4,1>& center = volume.getCenter();
+    bool sphereInside = true;
+    for (unsigned int p = 0 ; p < 6 ; p++) {
+        float distance = planes[p][0] * center[0] + planes[p][1] * center[1] + planes[p][2] * center[2] + planes[p][3];
+        if (distance < -volume.getRadius()) return OUTSIDE;
+        if (distance < volume.getRadius()) sphereInside = false;
+    }
+    if (sphereInside) return INSIDE;
+
+    // For each plane, test the corner of the box the furthest along the normal, then the nearest one
+    const Matrix<float,4,1>& minimum = volume.getMinimum();
+    const Matrix<float,4,1>& maximum = volume.getMaximum();
+    Intersection rtn = INSIDE;
+    for (unsigned int p = 0 ; p < 6 ; p++) {
+        float furthest = planes[p][3];
+        float nearest = planes[p][3];
+        for (unsigned int c = 0 ; c < 3 ; c++) {
+            furthest += planes[p][c] * (planes[p][c] >= 0 ? maximum[c] : minimum[c]);
+            nearest  += planes[p][c] * (planes[p][c] >= 0 ? minimum[c] : maximum[c]);
+        }
+        if (furthest < 0) return OUTSIDE;
+        if (nearest < 0) rtn = INTERSECTING;
+    }
+    return rtn;
+}
+
+
+
+#endif /* _BOUNDS_TCC */
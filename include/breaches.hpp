@@ -24,6 +24,9 @@
 
 /**
  * @brief Defines a breach.
+ *
+ * A breach is a plain value type (no virtual table, trivially copyable),
+ * so that \link ::breaches \endlink can be stored and copied as a packed array.
  */
 class Breach {
     public:
@@ -49,6 +52,8 @@ class Breach {
         * using -1/+1 for X and Y, and 0 for Z.
         */
         Matrix<float,4,4> transformation;
+        //! @brief The inverse of \link transformation \endlink, computed once the breach is shot.
+        Matrix<float,4,4> inverseTransformation;
 
         static Matrix<float,2,1> getAdjustedShotPoint     (const Wall& wall, const Matrix<float,2,1> shotPoint);
         static Matrix<float,4,4> getTransformationFromWall(const Wall& wall, const Matrix<float,2,1> shotPoint);
@@ -58,14 +63,15 @@ class Breach {
 
         Breach(Matrix<float,4,1> color);
         Breach(bool opened, const Wall& wall, Matrix<float,4,1> color, Matrix<float,2,1> shotPoint); //Matrix<float,4,4> transformation);
-        virtual ~Breach();
 
         bool isOpened() const;
         const Wall* getWall() const;
         Matrix<float,4,1> getColor() const;
         Matrix<float,2,1> getShotPoint() const;
         Matrix<float,4,4> getTransformation() const;
+        Matrix<float,4,4> getInverseTransformation() const;
 };
+static_assert(std::is_trivially_copyable<Breach>::value, "Breach must be trivially copyable");
 
 
 
@@ -93,6 +99,8 @@ class BreachRenderer : public SelectableLeafRenderable, public MatrixTransformer
         virtual void loadTransform(GLenum renderingMode);
         //! @brief Renders the breach
         virtual void render(GLenum renderingMode);
+        //! @brief Returns the volume of the transformed breach, or an empty volume if it is closed.
+        virtual BoundingVolume getBounds();
 };
 
 
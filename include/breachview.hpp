@@ -0,0 +1,306 @@
+/**
+ * @file breachview.hpp
+ *
+ * @brief Renders the scene seen through the breaches, using the stencil buffer.
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2011 Olivier Favre
+ *
+ * This file is part of Breach.
+ *
+ * Licensed under the Simplified BSD License,
+ * for details please see LICENSE file or the website
+ * http://www.opensource.org/licenses/BSD-2-Clause
+ */
+
+#ifndef _BREACHVIEW_HPP
+#define _BREACHVIEW_HPP 1
+
+#include <vector>
+#include <map>
+#include <GL/gl.h>
+
+#include "matrix.hpp"
+#include "renderable.hpp"
+#include "breaches.hpp"
+
+
+
+/**
+ * @brief Recursive rendering of the scene seen through the breaches, as planned in RENDERING.textile.
+ *
+ * The breaches are linked by pairs (the first with the second, and so on).
+ * Looking into an opened breach shows the scene as seen out of its linked breach, if opened too.
+ *
+ * Each recursion depth owns a stencil value, and the scene of a depth only touches the pixels holding it.
+ * Entering a breach:
+ * - marks the visible pixels of its hole (alpha tested breach texture, slightly offset towards the viewer),
+ *   incrementing their stencil value,
+ * - pushes the depth of these pixels back to the far plane,
+ * - loads the view transformed through the breach, with an oblique projection whose near plane is the linked breach,
+ *   so that what lies between the viewer and the linked breach (its wall first) is clipped away by the frustum itself.
+ *
+ * The caller then renders the scene again, the same way, before leaving the breach.
+ * Leaving restores the depth of the hole, and gives its pixels back to the previous depth.
+ *
+ * All these steps draw the breach quad, and never the whole viewport,
+ * so that the fill cost is proportional to the on screen area of the breach.
+ * The view is furthermore confined with \c glScissor() to the screen bounds of the projected breach corners,
+ * within the bounds of the enclosing view, and skipped when these bounds are empty.
+ *
+ * Breaches facing away from the viewer are skipped too.
+ * Marking the hole is an occlusion query, one per path of breaches looked through.
+ * When the query of the previous frame found no visible pixel, the view is skipped without waiting for the current one,
+ * a breach coming into sight thus showing its wall during a frame.
+ * Otherwise, with OpenGL 3.0, the view is rendered conditionally to the current query,
+ * so that the GPU drops it without stalling the CPU if the hole turns out to be hidden.
+ *
+ * With OpenGL 3.0 too, the view through each breach, nested views included, is kept in a framebuffer object,
+ * blitted from its scissor rectangle once rendered.
+ * While the camera, the breaches and the scene are unchanged, the hole is filled with this cached image instead.
+ * A moving camera keeps the cached image as long as the breach corners stay within the reprojection threshold
+ * of where they were projected when it was rendered (see \link setReprojectionThreshold() \endlink).
+ * Any other change to the scene must be told with \link invalidate() \endlink.
+ *
+ * Besides the maximum depth, at which the breaches simply show their wall, the recursion can be cut to a depth budget,
+ * given each frame by \link FrameBudget \endlink for the rendering to keep up with the frame rate.
+ * The holes at the budget depth are then filled with the color of their linked breach,
+ * or, for the outermost breaches, with the last cached view where it still covers the hole, even if out of date.
+ */
+class BreachView {
+    public:
+        //! @brief Default maximum recursion depth.
+        static const unsigned int DEFAULT_MAX_DEPTH = 3;
+        //! @brief Distance of the near plane in front of the linked breach, so that its wall does not hide the view.
+        static const double CLIP_OFFSET;
+        //! @brief Default reprojection threshold, in pixels.
+        static const float DEFAULT_REPROJECTION_THRESHOLD;
+
+    private:
+        //! @brief A breach being looked through.
+        struct Level {
+            //! @brief View matrix before entering the breach.
+            Matrix<float,4,4> view;
+            //! @brief Projection matrix before entering the breach.
+            Matrix<float,4,4> projection;
+            //! @brief Breach looked into.
+            const Breach* entrance;
+            //! @brief Breach looked out of.
+            const Breach* exit;
+            //! @brief Scissor rectangle of the view, as X, Y, width and height, in window coordinates.
+            GLint scissor[4];
+            //! @brief Whether this level started a conditional rendering.
+            bool conditional;
+            //! @brief Whether the rendered view is to be stored in the cache of the entrance, when leaving.
+            bool cached;
+            //! @brief View selecting the display lists replayed through the entrance (see \link CompiledRenderable::setView() \endlink).
+            unsigned int compiledView;
+        };
+        //! @brief Occlusion query marking the hole of a breach.
+        struct Query {
+            //! @brief Name of the query object.
+            GLuint name;
+            //! @brief Frame the query was last issued in.
+            unsigned long frame;
+        };
+        //! @brief Cached image of the view through an outermost breach.
+        struct Cache {
+            //! @brief Name of the framebuffer object, 0 until first used.
+            GLuint framebuffer;
+            //! @brief Name of the color texture attached to the framebuffer object, as large as the viewport.
+            GLuint texture;
+            //! @brief Whether the texture holds an image.
+            bool valid;
+            //! @brief Viewport the image was rendered in.
+            GLint viewport[4];
+            //! @brief Scissor rectangle the image was rendered in, the only pixels of the texture holding it.
+            GLint scissor[4];
+            //! @brief Projection times view matrix the image was rendered with.
+            Matrix<float,4,4> viewProjection;
+            //! @brief Transformations of all the breaches, the closed ones set to 0, when the image was rendered.
+            std::vector< Matrix<float,4,4> > transformations;
+            //! @brief Scene version the image was rendered at.
+            unsigned long sceneVersion;
+        };
+
+        //! @brief Breaches being looked through, the outermost first.
+        static std::vector<Level> levels;
+        //! @brief Maximum recursion depth.
+        static unsigned int maxDepth;
+        //! @brief Depth at which the recursion is cut, to keep up with the frame rate.
+        static unsigned int depthBudget;
+        //! @brief Largest depth the stencil buffer can hold.
+        static unsigned int stencilLimit;
+        //! @brief Texturer of the alpha only breach hole, NULL until \link init() \endlink.
+        static TexturerCompositeRenderable* holeTexturer;
+        //! @brief Viewport of the current frame, scissoring the outermost view.
+        static GLint viewport[4];
+        //! @brief Projection matrix of the current frame, made oblique for the views through the breaches.
+        static Matrix<float,4,4> projection;
+        //! @brief Occlusion queries, by path of breaches looked through (indices into \link ::breaches \endlink, the outermost first).
+        static std::map<std::vector<size_t>,Query> queries;
+        //! @brief Display list views (see \link CompiledRenderable::setView() \endlink), by path of breaches looked through, 0 being the main view.
+        static std::map<std::vector<size_t>,unsigned int> compiledViews;
+        //! @brief Number of the current frame.
+        static unsigned long frame;
+        //! @brief Whether conditional rendering is available.
+        static bool conditionalRendering;
+        //! @brief Number of views skipped since the beginning of the current frame.
+        static unsigned long skippedViews;
+        //! @brief Number of views skipped during the last complete frame.
+        static unsigned long lastFrameSkippedViews;
+        //! @brief Cached views, by index into \link ::breaches \endlink.
+        static std::vector<Cache> caches;
+        //! @brief Whether the views can be cached.
+        static bool caching;
+        //! @brief Reprojection threshold, in pixels, negative to disable the cache.
+        static float reprojectionThreshold;
+        //! @brief Version of the scene, increased by \link invalidate() \endlink.
+        static unsigned long sceneVersion;
+
+        //! @brief Draws the quad of a breach, textured with the hole.
+        static void drawQuad(const Breach& breach);
+        /**
+         * @brief Returns the projection of the current frame, with its near plane moved onto the given breach in the current view.
+         *
+         * The near plane is replaced as described by Eric Lengyel in "Oblique View Frustum Depth Projection and Clipping",
+         * the far plane going through the corner of the original frustum opposite to the new near plane.
+         * The projection of the frame must be a perspective one.
+         * If the viewer is in front of the breach, the projection of the frame is returned as is.
+         *
+         * @param exit Breach looked out of
+         */
+        static Matrix<float,4,4> getObliqueProjection(const Breach& exit);
+        //! @brief Loads the given projection matrix, for OpenGL and the culling.
+        static void loadProjection(const Matrix<float,4,4>& matrix);
+        //! @brief Restricts the rendering to the pixels of the given depth.
+        static void selectDepth(unsigned int depth);
+        /**
+         * @brief Computes the scissor rectangle of the view through a breach, seen in the current view.
+         *
+         * The corners of the breach are projected, and the rectangle bounding them is intersected with the enclosing one.
+         * If a corner lies behind the viewer, the enclosing rectangle is kept as is.
+         *
+         * @param entrance  Breach looked into
+         * @param enclosing Scissor rectangle of the current view
+         * @param scissor   Computed scissor rectangle
+         * @return Whether the rectangle is not empty, false if the breach is entirely off-screen.
+         */
+        static bool computeScissor(const Breach& entrance, const GLint* enclosing, GLint* scissor);
+        //! @brief Tells whether the given breach faces away from the viewer, in the current view.
+        static bool isFacingAway(const Breach& breach);
+        //! @brief Returns the path of breaches looked through to see through the given breach, from the current view (indices into \link ::breaches \endlink, the outermost first).
+        static std::vector<size_t> getPath(const Breach& entrance);
+        /**
+         * @brief Returns the occlusion query of the view through the given breach, from the current one.
+         *
+         * @param path     Path of breaches looked through
+         * @param occluded Set to whether the query of the previous frame found no visible pixel
+         */
+        static Query& getQuery(const std::vector<size_t>& path, bool& occluded);
+        //! @brief Gives the marked pixels of the hole back to the given depth, without any view in them.
+        static void unmark(const Breach& entrance, unsigned int depth);
+        //! @brief Returns the transformations of all the breaches, the closed ones set to 0.
+        static std::vector< Matrix<float,4,4> > getTransformations();
+        /**
+         * @brief Tells whether the cached view through the given outermost breach can be shown instead of rendering it.
+         *
+         * The viewport, the breaches and the scene version must be unchanged,
+         * the scissor rectangle must lie within the cached one,
+         * and the corners of the breach must be projected within the reprojection threshold of their cached position.
+         *
+         * @param entrance Breach looked into
+         * @param scissor  Scissor rectangle of the view
+         */
+        static bool isCached(const Breach& entrance, const GLint* scissor);
+        /**
+         * @brief Draws a rectangle in window coordinates.
+         *
+         * @param rectangle Rectangle to draw, as X, Y, width and height
+         * @param texture   Texture spanning from the origin of the window to the corner of the viewport, or 0 for the current color
+         * @param viewport  Viewport the texture was rendered in
+         */
+        static void drawRectangle(const GLint* rectangle, GLuint texture, const GLint* viewport);
+        /**
+         * @brief Fills the marked pixels of the hole of a level, instead of rendering its view, and gives them back to the given depth.
+         *
+         * @param level The level not to be entered
+         * @param depth Current depth
+         * @param cache Cached view to show, drawn where it covers the hole, or NULL
+         */
+        static void fill(const Level& level, unsigned int depth, const Cache* cache);
+        //! @brief Stores the rendered view of the given level in the cache of its entrance.
+        static void storeCache(const Level& level);
+
+    public:
+        /**
+         * @brief Initializes the hole texture, reads the stencil precision, and checks for conditional rendering and framebuffer objects, once the OpenGL context exists.
+         *
+         * Without any stencil bit, the breaches never show any view.
+         *
+         * @param hole Alpha only texture of the breach hole, transparent inside.
+         */
+        static void init(Texture hole);
+        //! @brief Returns the maximum recursion depth.
+        static unsigned int getMaxDepth();
+        //! @brief Sets the maximum recursion depth, 0 showing no view at all.
+        static void setMaxDepth(unsigned int depth);
+        //! @brief Returns the current recursion depth, 0 outside of any breach.
+        static unsigned int getDepth();
+        //! @brief Returns the depth at which the recursion is cut, below the maximum depth, to keep up with the frame rate.
+        static unsigned int getDepthBudget();
+        //! @brief Sets the depth at which the recursion is cut, showing the cached views or flat colors instead.
+        static void setDepthBudget(unsigned int depth);
+        //! @brief Returns the number of views skipped during the last complete frame, being off-screen, facing away, or hidden.
+        static unsigned long getSkippedViews();
+        //! @brief Returns the reprojection threshold, in pixels.
+        static float getReprojectionThreshold();
+        /**
+         * @brief Sets the reprojection threshold.
+         *
+         * @param pixels Largest distance, in pixels, the breach corners may be projected away from where they were
+         *               when the cached view was rendered, 0 requiring an unchanged camera,
+         *               and a negative value disabling the cache.
+         */
+        static void setReprojectionThreshold(float pixels);
+        //! @brief Tells that the scene changed, for the cached views to be rendered again.
+        static void invalidate();
+
+        //! @brief Returns the opened breach linked to the given one, or NULL if any of them is closed.
+        static const Breach* getLinkedBreach(const Breach& breach);
+        /**
+         * @brief Returns the transformation bringing the surroundings of the exit breach behind the entrance breach.
+         *
+         * The exit breach is turned around its vertical axis, so that looking into the entrance is looking out of the exit.
+         * Multiplying the view matrix by this transformation gives the view through the entrance.
+         *
+         * @param entrance Breach looked into
+         * @param exit     Breach looked out of
+         */
+        static Matrix<float,4,4> getLinkTransformation(const Breach& entrance, const Breach& exit);
+
+        //! @brief Clears the recursion, reads the viewport and the projection given to \link TransformStack \endlink, and restricts the rendering to the pixels of depth 0, the stencil buffer being cleared to 0.
+        static void beginFrame();
+        //! @brief Disables the stencil test and the scissor test, and counts the skipped views.
+        static void endFrame();
+        /**
+         * @brief Starts rendering the view through the given breach, inside its visible hole.
+         *
+         * Must be called once the scene of the current depth has been rendered, at least the parts that may hide the breach.
+         * Only the position of the light has to be given again for the new view.
+         *
+         * @param entrance Breach looked into
+         * @return Whether the view is to be rendered, before calling \link leave() \endlink.
+         *         False if the breach is not linked to another opened breach, if it is off-screen, facing away,
+         *         or was hidden during the previous frame, if the maximum depth is reached,
+         *         or if the cached view or a flat color was shown instead.
+         */
+        static bool enter(const Breach& entrance);
+        //! @brief Finishes rendering the view through the last entered breach, and loads back the previous view.
+        static void leave();
+};
+
+
+
+#endif /* _BREACHVIEW_HPP */
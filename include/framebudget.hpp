@@ -0,0 +1,87 @@
+/**
+ * @file framebudget.hpp
+ *
+ * @brief Adapts the breach recursion to the time available for each frame.
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2011 Olivier Favre
+ *
+ * This file is part of Breach.
+ *
+ * Licensed under the Simplified BSD License,
+ * for details please see LICENSE file or the website
+ * http://www.opensource.org/licenses/BSD-2-Clause
+ */
+
+#ifndef _FRAMEBUDGET_HPP
+#define _FRAMEBUDGET_HPP 1
+
+#include <sys/time.h>
+
+
+
+/**
+ * @brief Controller of the breach recursion depth, keeping the rendering time of a frame within a budget.
+ *
+ * The rendering time is measured on the CPU, from \link beginFrame() \endlink to \link endFrame() \endlink.
+ * The latter must be called once the GPU has finished the frame (after \c glFinish()), but before the buffer swap:
+ * the wait for the vertical synchronization would otherwise be accounted for,
+ * keeping the time around the refresh period whatever the depth.
+ * It is averaged over the last frames, and after each frame it picks the depth budget
+ * of \link BreachView \endlink for the next one:
+ * - over the budget, the depth budget is decreased,
+ * - under a fraction of the budget, it is increased, up to the maximum depth.
+ *
+ * After each change, the controller lets the averaged time settle for a few frames before changing it again.
+ */
+class FrameBudget {
+    public:
+        //! @brief Weight of the last frame in the averaged rendering time.
+        static const double SMOOTHING;
+        //! @brief Fraction of the budget under which the recursion gets deeper, leaving room for the deeper views.
+        static const double HEADROOM;
+        //! @brief Number of frames to wait after changing the depth budget.
+        static const unsigned int SETTLING_FRAMES = 15;
+
+    private:
+        //! @brief Time available for a frame, in seconds.
+        static double budget;
+        //! @brief Averaged rendering time, in seconds, 0 until a frame has been measured.
+        static double frameTime;
+        //! @brief Time the current frame began.
+        static timeval start;
+        //! @brief Number of frames still to wait before changing the depth budget.
+        static unsigned int settling;
+
+    public:
+        //! @brief Returns the time available for a frame, in seconds.
+        static double getBudget();
+        //! @brief Sets the time available for a frame, in seconds.
+        static void setBudget(double seconds);
+        //! @brief Returns the averaged rendering time, in seconds.
+        static double getFrameTime();
+        //! @brief Starts measuring the rendering time of a frame.
+        static void beginFrame();
+        /**
+         * @brief Finishes measuring the rendering time of a frame, and picks the depth budget of the next one.
+         *
+         * @param depth    Depth budget of the measured frame
+         * @param maxDepth Maximum recursion depth
+         * @return The depth budget of the next frame.
+         */
+        static unsigned int endFrame(unsigned int depth, unsigned int maxDepth);
+        /**
+         * @brief Accounts for a frame having taken the given rendering time, and picks the depth budget of the next one.
+         *
+         * @param seconds  Rendering time of the frame, in seconds
+         * @param depth    Depth budget of the frame
+         * @param maxDepth Maximum recursion depth
+         * @return The depth budget of the next frame.
+         */
+        static unsigned int addFrame(double seconds, unsigned int depth, unsigned int maxDepth);
+};
+
+
+
+#endif /* _FRAMEBUDGET_HPP */
@@ -0,0 +1,130 @@
+/**
+ * @file glstate.hpp
+ *
+ * @brief Shadowed OpenGL state, to elide redundant state changes.
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2011 Olivier Favre
+ *
+ * This file is part of Breach.
+ *
+ * Licensed under the Simplified BSD License,
+ * for details please see LICENSE file or the website
+ * http://www.opensource.org/licenses/BSD-2-Clause
+ */
+
+#ifndef _GLSTATE_HPP
+#define _GLSTATE_HPP 1
+
+#include <map>
+#include <utility>
+#include <GL/gl.h>
+
+
+
+/**
+ * @brief Shadow copy of the OpenGL state the renderables change the most.
+ *
+ * Each method mirrors the OpenGL function of the same name,
+ * and only forwards the call when it would actually change the state.
+ * A state is only known after it was set through this class:
+ * the first call for each state is always forwarded, whatever the OpenGL defaults are.
+ *
+ * Tracked states are capabilities, texture bindings (on the active texture unit only),
+ * texture parameters (per texture name), material properties (per face),
+ * blend function and equation, depth function, color mask and culled face.
+ *
+ * @remarks
+ * Any state changed without going through this class must be reported using \link invalidate() \endlink,
+ * as well as the deletion of a tracked texture.
+ * While a display list is being compiled, calls are recorded but not executed,
+ * so they are all forwarded without touching the shadow copy (see \link setRecording() \endlink);
+ * as executing a display list changes the state behind this class back, it must be followed by \link invalidate() \endlink.
+ */
+class GLStateCache {
+    private:
+        //! @brief Whether each capability is enabled.
+        static std::map<GLenum,bool> capabilities;
+        //! @brief Texture bound to each target.
+        static std::map<GLenum,GLuint> boundTextures;
+        //! @brief Integer parameters of each texture, by texture name and parameter name.
+        static std::map<std::pair<GLuint,GLenum>,GLint> textureParameters;
+        //! @brief Value of a material property, unused components being 0.
+        struct MaterialValue {
+            GLfloat values[4];
+        };
+        //! @brief Material properties, by face (\c GL_FRONT or \c GL_BACK) and property name.
+        static std::map<std::pair<GLenum,GLenum>,MaterialValue> materials;
+        //! @brief Whether \link blendSource \endlink and \link blendDestination \endlink are known.
+        static bool blendFuncKnown;
+        //! @brief Source factor of the blend function.
+        static GLenum blendSource;
+        //! @brief Destination factor of the blend function.
+        static GLenum blendDestination;
+        //! @brief Whether \link blendEquationMode \endlink is known.
+        static bool blendEquationKnown;
+        //! @brief Blend equation.
+        static GLenum blendEquationMode;
+        //! @brief Whether \link depthFunction \endlink is known.
+        static bool depthFuncKnown;
+        //! @brief Depth comparison function.
+        static GLenum depthFunction;
+        //! @brief Whether \link colorMaskValues \endlink is known.
+        static bool colorMaskKnown;
+        //! @brief Red, green, blue and alpha write masks.
+        static GLboolean colorMaskValues[4];
+        //! @brief Whether \link cullFaceMode \endlink is known.
+        static bool cullFaceKnown;
+        //! @brief Culled faces.
+        static GLenum cullFaceMode;
+        //! @brief Whether a display list is being compiled.
+        static bool recording;
+        //! @brief Number of calls elided since the beginning of the current frame.
+        static unsigned long elidedCalls;
+        //! @brief Number of calls elided during the last complete frame.
+        static unsigned long lastFrameElidedCalls;
+
+        /**
+         * @brief Tells whether a call has to be forwarded to OpenGL, and counts it if it is elided.
+         *
+         * @param changes Whether the call changes the shadowed state.
+         */
+        static bool mustForward(bool changes);
+        //! @brief Sets a material property of a single face, returning whether it changed.
+        static bool updateMaterial(GLenum face, GLenum pname, const MaterialValue& value);
+
+    public:
+        static void enable(GLenum capability);
+        static void disable(GLenum capability);
+        static void bindTexture(GLenum target, GLuint texture);
+        static void texParameteri(GLenum target, GLenum pname, GLint param);
+        static void materialfv(GLenum face, GLenum pname, const GLfloat* params);
+        static void materialf(GLenum face, GLenum pname, GLfloat param);
+        static void blendFunc(GLenum sfactor, GLenum dfactor);
+        static void blendEquation(GLenum mode);
+        static void depthFunc(GLenum func);
+        static void colorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha);
+        static void cullFace(GLenum mode);
+
+        //! @brief Forgets the whole shadow copy, after the state got changed behind this class.
+        static void invalidate();
+        //! @brief Tells whether a display list is being compiled.
+        static bool isRecording();
+        /**
+         * @brief Sets whether a display list is being compiled.
+         *
+         * Once the compilation ends, the shadow copy is still valid,
+         * as the recorded calls were not executed.
+         */
+        static void setRecording(bool recording);
+
+        //! @brief Ends the current frame, making its number of elided calls available through \link getElidedCalls() \endlink.
+        static void endFrame();
+        //! @brief Returns the number of calls elided during the last complete frame.
+        static unsigned long getElidedCalls();
+};
+
+
+
+#endif /* _GLSTATE_HPP */
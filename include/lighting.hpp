@@ -0,0 +1,140 @@
+/**
+ * @file lighting.hpp
+ *
+ * @brief Per pixel lighting, using a GLSL program.
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2011 Olivier Favre
+ *
+ * This file is part of Breach.
+ *
+ * Licensed under the Simplified BSD License,
+ * for details please see LICENSE file or the website
+ * http://www.opensource.org/licenses/BSD-2-Clause
+ */
+
+#ifndef _LIGHTING_HPP
+#define _LIGHTING_HPP 1
+
+#include <GL/gl.h>
+
+#include "renderable.hpp"
+
+
+
+/**
+ * @brief GLSL program evaluating the fixed function lighting per pixel, instead of per vertex.
+ *
+ * The program reproduces the fixed function pipeline for \c GL_LIGHT0 only:
+ * global and light ambient, diffuse, specular with a local viewer,
+ * and the constant, linear and quadratic attenuation of a positional light.
+ * The front material is used, for both faces.
+ * As with \c GL_LIGHT_MODEL_TWO_SIDE, the normal is reversed for back faces.
+ * The lit color modulates the texture bound to the first texture unit, which must be enabled.
+ *
+ * As lighting no longer depends on the vertices, lit surfaces need no tesselation (see \link TesseledRectangle \endlink).
+ *
+ * The program only targets GLSL 1.20, and the compatibility built-in variables.
+ * If it is not available, the fixed function pipeline is used as a fallback.
+ *
+ * With OpenGL 3.3, an instanced variant of the program is also available (see \link bindInstanced() \endlink).
+ * It places, and scales, a unit square per instance, read from the \c instance attribute.
+ */
+class PerPixelLighting {
+    private:
+        //! @brief The linked program, 0 if not available.
+        static GLuint program;
+        //! @brief The linked instanced program, 0 if not available.
+        static GLuint instancedProgram;
+        //! @brief Location of the per instance attribute of \link #instancedProgram \endlink.
+        static GLint instanceAttribute;
+        //! @brief Whether per pixel lighting is requested.
+        static bool enabled;
+        //! @brief Whether the program is currently in use.
+        static bool bound;
+
+        /**
+         * @brief Compiles a shader, printing the log on failure.
+         *
+         * @param type   Type of the shader
+         * @param source Source code of the shader
+         * @return The compiled shader, or 0 on failure.
+         */
+        static GLuint compile(GLenum type, const char* source);
+        /**
+         * @brief Compiles and links a program, printing the log on failure.
+         *
+         * The texture is read from the first texture unit.
+         *
+         * @param vertexSource   Source code of the vertex shader
+         * @param fragmentSource Source code of the fragment shader
+         * @return The linked program, or 0 on failure.
+         */
+        static GLuint link(const char* vertexSource, const char* fragmentSource);
+
+    public:
+        /**
+         * @brief Compiles and links the programs, once the OpenGL context exists.
+         *
+         * @return Whether the program is available.
+         */
+        static bool init();
+        //! @brief Tells whether the program is available.
+        static bool isAvailable();
+        //! @brief Tells whether per pixel lighting is requested.
+        static bool isEnabled();
+        //! @brief Requests per pixel lighting, or the fixed function pipeline.
+        static void setEnabled(bool enabled);
+        //! @brief Tells whether the program is currently in use, and the lighting computed per pixel.
+        static bool isBound();
+        //! @brief Uses the program, if it is available and enabled.
+        static void bind();
+        //! @brief Goes back to the fixed function pipeline.
+        static void unbind();
+
+        //! @brief Tells whether the instanced program is available, and per pixel lighting requested.
+        static bool isInstancingAvailable();
+        /**
+         * @brief Uses the instanced program, until \link unbindInstanced() \endlink.
+         *
+         * Each instance is a unit square, spanning [0,1] along X and Y (as a \link TesseledRectangle \endlink),
+         * centered on the XYZ components of the \c instance attribute, and scaled by its W component.
+         * The attribute must be fed with a divisor of 1.
+         *
+         * @return The location of the \c instance attribute.
+         */
+        static GLint bindInstanced();
+        //! @brief Goes back to the program used before \link bindInstanced() \endlink.
+        static void unbindInstanced();
+};
+
+
+
+/**
+ * @brief Composite renderable lighting its components per pixel.
+ *
+ * All the components must be textured.
+ * In any other mode than \c GL_RENDER, the fixed function pipeline is kept.
+ *
+ * @see PerPixelLighting
+ */
+class PerPixelLightingCompositeRenderable : public CompositeRenderable, public QueueableRenderable {
+    public:
+        //! @brief Creates a per pixel lighting composite renderable, with a single component.
+        //! @param component The component to light
+        PerPixelLightingCompositeRenderable(IRenderable* component);
+        //! @brief Destructor.
+        virtual ~PerPixelLightingCompositeRenderable();
+
+        //! @brief Uses the program.
+        virtual void configure(GLenum renderingMode);
+        //! @brief Requests per pixel lighting in the state.
+        virtual bool describeState(RenderState& state);
+        //! @brief Goes back to the fixed function pipeline.
+        virtual void deconfigure(GLenum renderingMode);
+};
+
+
+
+#endif /* _LIGHTING_HPP */
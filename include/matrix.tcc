@@ -23,15 +23,6 @@
 
 
 
-#include <cstdarg>
-
-
-
-template <typename Value, unsigned int lines, unsigned int cols>
-Matrix<Value,lines,cols>::Matrix()
-{
-}
-
 template <typename Value, unsigned int lines, unsigned int cols>
 Matrix<Value,lines,cols>::Matrix(Value fill_value)
 {
@@ -45,19 +36,10 @@ Matrix<Value,lines,cols>::Matrix(const Value values[cols][lines])
 }
 
 template <typename Value, unsigned int lines, unsigned int cols>
-Matrix<Value,lines,cols>::Matrix(Value enoughValues, ...)
-{
-    va_list args;
-    va_start(args, enoughValues);
-    Value* ptr = values;
-    *ptr = enoughValues;
-    ptr++;
-    for (unsigned int i = lines*cols-1 ; ; --i) {
-        *ptr = va_arg(args, Value);
-        ptr++;
-        if (i == 0) break;
-    }
-    va_end(args);
+template <typename... Values, typename>
+constexpr Matrix<Value,lines,cols>::Matrix(Value first, Values... others)
+: values{first, static_cast<Value>(others)...}
+{
 }
 
 template <typename Value, unsigned int lines, unsigned int cols>
@@ -66,10 +48,6 @@ Matrix<Value,lines,cols>::Matrix(const Value values[cols*lines])
     take(values);
 }
 
-template <typename Value, unsigned int lines, unsigned int cols>
-Matrix<Value,lines,cols>::~Matrix()
-{
-}
 
 
 template <typename Value>
@@ -95,9 +73,9 @@ Matrix<Value,4,4> MatrixHelper::rotation(double angle, const Matrix<Value,4,1> &
         rtn(0,i) *= normalizedAxis(i,0) * oneMinusC;
         rtn(1,i) *= normalizedAxis(i,0) * oneMinusC;
         rtn(2,i) *= normalizedAxis(i,0) * oneMinusC;
-        rtn(i,0) *= normalizedAxis(i,0) * oneMinusC;
-        rtn(i,1) *= normalizedAxis(i,0) * oneMinusC;
-        rtn(i,2) *= normalizedAxis(i,0) * oneMinusC;
+        rtn(i,0) *= normalizedAxis(i,0);
+        rtn(i,1) *= normalizedAxis(i,0);
+        rtn(i,2) *= normalizedAxis(i,0);
         rtn(i,i) += c;
     }
     rtn(0,1) -= normalizedAxis(2,0) * s;
@@ -110,12 +88,7 @@ Matrix<Value,4,4> MatrixHelper::rotation(double angle, const Matrix<Value,4,1> &
 }
 
 template <typename Value>
-Matrix<Value,4,4> MatrixHelper::translation(Value x, Value y, Value z)
-{
-    return MatrixHelper::translation<Value>(Matrix<Value,4,1>((Value[4]){x,y,z,1}));
-}
-template <typename Value>
-Matrix<Value,4,4> MatrixHelper::translation(const Matrix<Value,4,1> &vector)
+constexpr Matrix<Value,4,4> MatrixHelper::translation(Value x, Value y, Value z)
 {
     /*
      *  / 1 0 0 x \
@@ -123,21 +96,15 @@ Matrix<Value,4,4> MatrixHelper::translation(const Matrix<Value,4,1> &vector)
      * |  0 0 1 z  |
      *  \ 0 0 0 1 /
      */
-    Matrix<Value,4,4> rtn (static_cast<Value>(0));
-    for (unsigned int i = 0 ; i < 3 ; ++i) {
-        rtn(i,3) = vector(i,0);
-        rtn(i,i) = static_cast<Value>(1);
-    }
-    rtn(3,3) = static_cast<Value>(1);
-    return rtn;
+    return Matrix<Value,4,4>(1,0,0,0, 0,1,0,0, 0,0,1,0, x,y,z,1);
 }
 template <typename Value>
-Matrix<Value,4,4> MatrixHelper::scaling(Value x, Value y, Value z)
+Matrix<Value,4,4> MatrixHelper::translation(const Matrix<Value,4,1> &vector)
 {
-    return MatrixHelper::scaling<Value>(Matrix<Value,4,1>((Value[4]){x,y,z,1}));
+    return MatrixHelper::translation<Value>(vector(0,0), vector(1,0), vector(2,0));
 }
 template <typename Value>
-Matrix<Value,4,4> MatrixHelper::scaling(const Matrix<Value,4,1> &vector)
+constexpr Matrix<Value,4,4> MatrixHelper::scaling(Value x, Value y, Value z)
 {
     /*
      *  / x 0 0 0 \
@@ -145,22 +112,17 @@ Matrix<Value,4,4> MatrixHelper::scaling(const Matrix<Value,4,1> &vector)
      * |  0 0 z 0  |
      *  \ 0 0 0 1 /
      */
-    Matrix<Value,4,4> rtn (static_cast<Value>(0));
-    for (unsigned int i = 0 ; i < 3 ; ++i) {
-        rtn(i,i) = vector(i,0);
-    }
-    rtn(3,3) = static_cast<Value>(1);
-    return rtn;
+    return Matrix<Value,4,4>(x,0,0,0, 0,y,0,0, 0,0,z,0, 0,0,0,1);
 }
 template <typename Value>
-Matrix<Value,4,4> MatrixHelper::identity()
+Matrix<Value,4,4> MatrixHelper::scaling(const Matrix<Value,4,1> &vector)
 {
-    Matrix<Value,4,4> rtn;
-    rtn.fill(static_cast<Value>(0));
-    for (unsigned int i = 0 ; i < 4 ; ++i) {
-        rtn(i,i) = static_cast<Value>(1);
-    }
-    return rtn;
+    return MatrixHelper::scaling<Value>(vector(0,0), vector(1,0), vector(2,0));
+}
+template <typename Value>
+constexpr Matrix<Value,4,4> MatrixHelper::identity()
+{
+    return Matrix<Value,4,4>(1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1);
 }
 
 template <typename Value, unsigned int lines, unsigned int cols>
@@ -188,25 +150,47 @@ void MatrixHelper::print(const Matrix<Value,lines,cols> matrix, std::ostream& ou
 }
 
 template <typename Value>
-Matrix<Value,4,1> MatrixHelper::unitAxisVector(unsigned int axis)
+constexpr Matrix<Value,4,1> MatrixHelper::unitAxisVector(unsigned int axis)
 {
-    assert(axis < 3);
-    Matrix<Value,4,1> rtn;
-    rtn.fill(static_cast<Value>(0));
-    rtn(axis,0) = static_cast<Value>(1);
     // Always set the fourth component to 1
-    rtn(3,0) = static_cast<Value>(1);
-    return rtn;
+    return assert(axis < 3), Matrix<Value,4,1>(axis == 0 ? 1 : 0, axis == 1 ? 1 : 0, axis == 2 ? 1 : 0, 1);
 }
 
 template <typename Value>
-Matrix<Value,3,1> MatrixHelper::unitRotationAxisVector(unsigned int axis)
+constexpr Matrix<Value,3,1> MatrixHelper::unitRotationAxisVector(unsigned int axis)
 {
-    assert(axis < 3);
-    Matrix<Value,3,1> rtn;
-    rtn.fill(static_cast<Value>(0));
-    rtn(axis,0) = static_cast<Value>(1);
-    return rtn;
+    return assert(axis < 3), Matrix<Value,3,1>(axis == 0 ? 1 : 0, axis == 1 ? 1 : 0, axis == 2 ? 1 : 0);
+}
+
+template <typename Value>
+void MatrixHelper::transformBatch(const Matrix<Value,4,4> &transformation, std::size_t count,
+                                  const Value *x, const Value *y, const Value *z, Value w,
+                                  Value *outX, Value *outY, Value *outZ)
+{
+    const Matrix<Value,4,4> &m = transformation;
+    for (std::size_t i = 0 ; i < count ; ++i) {
+        // Same accumulation order as the matrix product
+        Value xi = x[i], yi = y[i], zi = z[i];
+        outX[i] = static_cast<Value>(0) + m(0,3)*w + m(0,2)*zi + m(0,1)*yi + m(0,0)*xi;
+        outY[i] = static_cast<Value>(0) + m(1,3)*w + m(1,2)*zi + m(1,1)*yi + m(1,0)*xi;
+        outZ[i] = static_cast<Value>(0) + m(2,3)*w + m(2,2)*zi + m(2,1)*yi + m(2,0)*xi;
+    }
+}
+
+template <typename Value>
+void MatrixHelper::transformBatch(const Matrix<Value,4,4> &transformation, std::size_t count,
+                                  const Value *x, const Value *y, const Value *z, const Value *w,
+                                  Value *outX, Value *outY, Value *outZ, Value *outW)
+{
+    const Matrix<Value,4,4> &m = transformation;
+    for (std::size_t i = 0 ; i < count ; ++i) {
+        // Same accumulation order as the matrix product
+        Value xi = x[i], yi = y[i], zi = z[i], wi = w[i];
+        outX[i] = static_cast<Value>(0) + m(0,3)*wi + m(0,2)*zi + m(0,1)*yi + m(0,0)*xi;
+        outY[i] = static_cast<Value>(0) + m(1,3)*wi + m(1,2)*zi + m(1,1)*yi + m(1,0)*xi;
+        outZ[i] = static_cast<Value>(0) + m(2,3)*wi + m(2,2)*zi + m(2,1)*yi + m(2,0)*xi;
+        outW[i] = static_cast<Value>(0) + m(3,3)*wi + m(3,2)*zi + m(3,1)*yi + m(3,0)*xi;
+    }
 }
 
 
@@ -279,71 +263,60 @@ Matrix<Value,lines,finalCols> Matrix<Value,lines,cols>::operator*(const Matrix<V
     return rtn;
 }
 
-template <typename Value, unsigned int lines, unsigned int cols>
-Matrix<Value,lines,cols> Matrix<Value,lines,cols>::operator+(const Matrix<Value,lines,cols> &b) const
+template <class Derived, typename Value, unsigned int lines, unsigned int cols>
+template <class Right>
+MatrixBinaryExpression<Derived,Right,MatrixOperation::Add,Value,lines,cols> MatrixExpression<Derived,Value,lines,cols>::operator+(const MatrixExpression<Right,Value,lines,cols> &b) const
 {
-    Matrix<Value,lines,cols> rtn (*this);
-    for (unsigned int i = lines*cols-1 ; ; --i) {
-        rtn.values[i] += b.values[i];
-        if (i == 0) break;
-    }
-    return rtn;
+    return MatrixBinaryExpression<Derived,Right,MatrixOperation::Add,Value,lines,cols>(self(), b.self());
 }
 
-template <typename Value, unsigned int lines, unsigned int cols>
-Matrix<Value,lines,cols> Matrix<Value,lines,cols>::operator-(const Matrix<Value,lines,cols> &b) const
+template <class Derived, typename Value, unsigned int lines, unsigned int cols>
+template <class Right>
+MatrixBinaryExpression<Derived,Right,MatrixOperation::Subtract,Value,lines,cols> MatrixExpression<Derived,Value,lines,cols>::operator-(const MatrixExpression<Right,Value,lines,cols> &b) const
 {
-    Matrix<Value,lines,cols> rtn (*this);
-    for (unsigned int i = lines*cols-1 ; ; --i) {
-        rtn.values[i] -= b.values[i];
-        if (i == 0) break;
-    }
-    return rtn;
+    return MatrixBinaryExpression<Derived,Right,MatrixOperation::Subtract,Value,lines,cols>(self(), b.self());
 }
 
+template <class Derived, typename Value, unsigned int lines, unsigned int cols>
+MatrixScalarExpression<Derived,MatrixOperation::Multiply,Value,lines,cols> MatrixExpression<Derived,Value,lines,cols>::operator*(Value b) const
+{
+    return MatrixScalarExpression<Derived,MatrixOperation::Multiply,Value,lines,cols>(self(), b);
+}
 
-template <typename Value, unsigned int lines, unsigned int cols>
-Matrix<Value,lines,cols> Matrix<Value,lines,cols>::operator*(Value b) const
+template <class Derived, typename Value, unsigned int lines, unsigned int cols>
+MatrixScalarExpression<Derived,MatrixOperation::Divide,Value,lines,cols> MatrixExpression<Derived,Value,lines,cols>::operator/(Value b) const
 {
-    Matrix<Value,lines,cols> rtn (*this);
-    for (unsigned int i = lines*cols-1 ; ; --i) {
-        rtn.values[i] *= b;
-        if (i == 0) break;
-    }
-    return rtn;
+    return MatrixScalarExpression<Derived,MatrixOperation::Divide,Value,lines,cols>(self(), b);
 }
 
-template <typename Value, unsigned int lines, unsigned int cols>
-Matrix<Value,lines,cols> Matrix<Value,lines,cols>::operator/(Value b) const
+template <class Derived, typename Value, unsigned int lines, unsigned int cols>
+MatrixScalarExpression<Derived,MatrixOperation::Add,Value,lines,cols> MatrixExpression<Derived,Value,lines,cols>::operator+(Value b) const
 {
-    Matrix<Value,lines,cols> rtn (*this);
-    for (unsigned int i = lines*cols-1 ; ; --i) {
-        rtn.values[i] /= b;
-        if (i == 0) break;
-    }
-    return rtn;
+    return MatrixScalarExpression<Derived,MatrixOperation::Add,Value,lines,cols>(self(), b);
+}
+
+template <class Derived, typename Value, unsigned int lines, unsigned int cols>
+MatrixScalarExpression<Derived,MatrixOperation::Subtract,Value,lines,cols> MatrixExpression<Derived,Value,lines,cols>::operator-(Value b) const
+{
+    return MatrixScalarExpression<Derived,MatrixOperation::Subtract,Value,lines,cols>(self(), b);
 }
 
 template <typename Value, unsigned int lines, unsigned int cols>
-Matrix<Value,lines,cols> Matrix<Value,lines,cols>::operator+(Value b) const
+template <class Derived>
+Matrix<Value,lines,cols>::Matrix(const MatrixExpression<Derived,Value,lines,cols> &expression)
 {
-    Matrix<Value,lines,cols> rtn (*this);
-    for (unsigned int i = lines*cols-1 ; ; --i) {
-        rtn.values[i] += b;
-        if (i == 0) break;
-    }
-    return rtn;
+    *this = expression;
 }
 
 template <typename Value, unsigned int lines, unsigned int cols>
-Matrix<Value,lines,cols> Matrix<Value,lines,cols>::operator-(Value b) const
+template <class Derived>
+Matrix<Value,lines,cols>& Matrix<Value,lines,cols>::operator=(const MatrixExpression<Derived,Value,lines,cols> &expression)
 {
-    Matrix<Value,lines,cols> rtn (*this);
-    for (unsigned int i = lines*cols-1 ; ; --i) {
-        rtn.values[i] -= b;
-        if (i == 0) break;
+    const Derived& e = expression.self();
+    for (unsigned int i = 0 ; i < lines*cols ; ++i) {
+        values[i] = e[i];
     }
-    return rtn;
+    return *this;
 }
 
 
@@ -382,9 +355,559 @@ Value& Matrix<Value,lines,cols>::operator[](unsigned int index)
 template <typename Value>
 Matrix<Value,4,1> operator* (Matrix<Value,4,1> u, Matrix<Value,4,1> v)
 {
-    return Matrix<Value,4,1>((Value[4]){u(1,0)*v(2,0)-u(2,0)*v(1,0),u(2,0)*v(0,0)-u(0,0)*v(2,0),u(0,0)*v(1,0)-u(1,0)*v(0,0),1});
+    return Matrix<Value,4,1>(u(1,0)*v(2,0)-u(2,0)*v(1,0), u(2,0)*v(0,0)-u(0,0)*v(2,0), u(0,0)*v(1,0)-u(1,0)*v(0,0), 1);
+}
+
+
+template <typename Value>
+bool MatrixHelper::isOrthonormal(const Matrix<Value,4,4> &matrix)
+{
+    const Value tolerance = 64 * std::numeric_limits<Value>::epsilon();
+    // Each pair of columns of the rotation part must have a null dot product, unless it is the same column
+    for (unsigned int i = 0 ; i < 3 ; ++i) {
+        for (unsigned int j = i ; j < 3 ; ++j) {
+            Value dot = matrix(0,i)*matrix(0,j) + matrix(1,i)*matrix(1,j) + matrix(2,i)*matrix(2,j);
+            if (std::fabs(dot - (i == j ? 1 : 0)) > tolerance)
+                return false;
+        }
+    }
+    return true;
+}
+
+template <typename Value>
+Matrix<Value,4,4> MatrixHelper::affineInverse(const Matrix<Value,4,4> &matrix, bool orthonormal)
+{
+    /*
+     *  / A t \^-1    / A^-1  -A^-1 t \
+     *  \ 0 1 /    =  \  0       1    /
+     * Where A^-1 = A^T for a rotation.
+     */
+    assert(matrix(3,0) == 0 && matrix(3,1) == 0 && matrix(3,2) == 0 && matrix(3,3) == 1);
+    Matrix<Value,4,4> rtn;
+    if (orthonormal || isOrthonormal(matrix)) {
+        for (unsigned int l = 0 ; l < 3 ; ++l)
+            for (unsigned int c = 0 ; c < 3 ; ++c)
+                rtn(l,c) = matrix(c,l);
+    } else {
+        // Adjugate divided by the determinant
+        const Matrix<Value,4,4> &m = matrix;
+        rtn(0,0) = m(1,1)*m(2,2) - m(1,2)*m(2,1);
+        rtn(0,1) = m(0,2)*m(2,1) - m(0,1)*m(2,2);
+        rtn(0,2) = m(0,1)*m(1,2) - m(0,2)*m(1,1);
+        rtn(1,0) = m(1,2)*m(2,0) - m(1,0)*m(2,2);
+        rtn(1,1) = m(0,0)*m(2,2) - m(0,2)*m(2,0);
+        rtn(1,2) = m(0,2)*m(1,0) - m(0,0)*m(1,2);
+        rtn(2,0) = m(1,0)*m(2,1) - m(1,1)*m(2,0);
+        rtn(2,1) = m(0,1)*m(2,0) - m(0,0)*m(2,1);
+        rtn(2,2) = m(0,0)*m(1,1) - m(0,1)*m(1,0);
+        Value det = m(0,0)*rtn(0,0) + m(0,1)*rtn(1,0) + m(0,2)*rtn(2,0);
+        assert(det != 0);
+        for (unsigned int l = 0 ; l < 3 ; ++l)
+            for (unsigned int c = 0 ; c < 3 ; ++c)
+                rtn(l,c) /= det;
+    }
+    for (unsigned int l = 0 ; l < 3 ; ++l) {
+        rtn(l,3) = -(rtn(l,0)*matrix(0,3) + rtn(l,1)*matrix(1,3) + rtn(l,2)*matrix(2,3));
+        rtn(3,l) = static_cast<Value>(0);
+    }
+    rtn(3,3) = static_cast<Value>(1);
+    return rtn;
+}
+
+template <typename Value>
+Matrix<Value,4,4> MatrixHelper::normalMatrix(const Matrix<Value,4,4> &matrix, bool orthonormal)
+{
+    Matrix<Value,4,4> rtn;
+    if (orthonormal || isOrthonormal(matrix)) {
+        rtn = matrix;
+    } else {
+        Matrix<Value,4,4> inv = affineInverse(matrix, false);
+        for (unsigned int l = 0 ; l < 3 ; ++l)
+            for (unsigned int c = 0 ; c < 3 ; ++c)
+                rtn(l,c) = inv(c,l);
+    }
+    for (unsigned int i = 0 ; i < 3 ; ++i)
+        rtn(i,3) = rtn(3,i) = static_cast<Value>(0);
+    rtn(3,3) = static_cast<Value>(1);
+    return rtn;
+}
+
+template <typename Value>
+Matrix<Value,4,4> MatrixHelper::inverse(const Matrix<Value,4,4> &matrix)
+{
+    /*
+     * Cramer's rule, sharing the 2x2 sub-determinants
+     * of the first two columns (s) and of the last two columns (c).
+     */
+    const Matrix<Value,4,4> &m = matrix;
+    Value s0 = m(0,0)*m(1,1) - m(1,0)*m(0,1);
+    Value s1 = m(0,0)*m(1,2) - m(1,0)*m(0,2);
+    Value s2 = m(0,0)*m(1,3) - m(1,0)*m(0,3);
+    Value s3 = m(0,1)*m(1,2) - m(1,1)*m(0,2);
+    Value s4 = m(0,1)*m(1,3) - m(1,1)*m(0,3);
+    Value s5 = m(0,2)*m(1,3) - m(1,2)*m(0,3);
+    Value c5 = m(2,2)*m(3,3) - m(3,2)*m(2,3);
+    Value c4 = m(2,1)*m(3,3) - m(3,1)*m(2,3);
+    Value c3 = m(2,1)*m(3,2) - m(3,1)*m(2,2);
+    Value c2 = m(2,0)*m(3,3) - m(3,0)*m(2,3);
+    Value c1 = m(2,0)*m(3,2) - m(3,0)*m(2,2);
+    Value c0 = m(2,0)*m(3,1) - m(3,0)*m(2,1);
+    Value det = s0*c5 - s1*c4 + s2*c3 + s3*c2 - s4*c1 + s5*c0;
+    assert(det != 0);
+    Value invDet = 1 / det;
+    Matrix<Value,4,4> rtn;
+    rtn(0,0) = ( m(1,1)*c5 - m(1,2)*c4 + m(1,3)*c3) * invDet;
+    rtn(0,1) = (-m(0,1)*c5 + m(0,2)*c4 - m(0,3)*c3) * invDet;
+    rtn(0,2) = ( m(3,1)*s5 - m(3,2)*s4 + m(3,3)*s3) * invDet;
+    rtn(0,3) = (-m(2,1)*s5 + m(2,2)*s4 - m(2,3)*s3) * invDet;
+    rtn(1,0) = (-m(1,0)*c5 + m(1,2)*c2 - m(1,3)*c1) * invDet;
+    rtn(1,1) = ( m(0,0)*c5 - m(0,2)*c2 + m(0,3)*c1) * invDet;
+    rtn(1,2) = (-m(3,0)*s5 + m(3,2)*s2 - m(3,3)*s1) * invDet;
+    rtn(1,3) = ( m(2,0)*s5 - m(2,2)*s2 + m(2,3)*s1) * invDet;
+    rtn(2,0) = ( m(1,0)*c4 - m(1,1)*c2 + m(1,3)*c0) * invDet;
+    rtn(2,1) = (-m(0,0)*c4 + m(0,1)*c2 - m(0,3)*c0) * invDet;
+    rtn(2,2) = ( m(3,0)*s4 - m(3,1)*s2 + m(3,3)*s0) * invDet;
+    rtn(2,3) = (-m(2,0)*s4 + m(2,1)*s2 - m(2,3)*s0) * invDet;
+    rtn(3,0) = (-m(1,0)*c3 + m(1,1)*c1 - m(1,2)*c0) * invDet;
+    rtn(3,1) = ( m(0,0)*c3 - m(0,1)*c1 + m(0,2)*c0) * invDet;
+    rtn(3,2) = (-m(3,0)*s3 + m(3,1)*s1 - m(3,2)*s0) * invDet;
+    rtn(3,3) = ( m(2,0)*s3 - m(2,1)*s1 + m(2,2)*s0) * invDet;
+    return rtn;
+}
+
+template <typename Value>
+Matrix<Value,4,4> MatrixHelper::lookAt(const Matrix<Value,4,1> &eye, const Matrix<Value,4,1> &center, const Matrix<Value,4,1> &up)
+{
+    // Same construction as gluLookAt(): forward, side = forward * up, and the recomputed up = side * forward
+    Matrix<Value,4,1> forward = center - eye;
+    forward = forward / forward.norm();
+    Matrix<Value,4,1> side = forward * up;
+    side = side / side.norm();
+    Matrix<Value,4,1> trueUp = side * forward;
+    Matrix<Value,4,4> rtn;
+    for (unsigned int i = 0 ; i < 3 ; ++i) {
+        rtn(0,i) = side(i,0);
+        rtn(1,i) = trueUp(i,0);
+        rtn(2,i) = -forward(i,0);
+        rtn(3,i) = static_cast<Value>(0);
+    }
+    for (unsigned int l = 0 ; l < 3 ; ++l)
+        rtn(l,3) = -(rtn(l,0)*eye(0,0) + rtn(l,1)*eye(1,0) + rtn(l,2)*eye(2,0));
+    rtn(3,3) = static_cast<Value>(1);
+    return rtn;
+}
+
+template <typename Value>
+Matrix<Value,4,4> MatrixHelper::perspective(double fovy, double aspect, double zNear, double zFar)
+{
+    // Same construction as gluPerspective(), f being the cotangent of half the field of view
+    double f = 1 / tan(fovy * M_PI / 360);
+    Matrix<Value,4,4> rtn = identity<Value>();
+    rtn(0,0) = static_cast<Value>(f / aspect);
+    rtn(1,1) = static_cast<Value>(f);
+    rtn(2,2) = static_cast<Value>((zFar + zNear) / (zNear - zFar));
+    rtn(2,3) = static_cast<Value>(2 * zFar * zNear / (zNear - zFar));
+    rtn(3,2) = static_cast<Value>(-1);
+    rtn(3,3) = static_cast<Value>(0);
+    return rtn;
+}
+
+template <typename Value>
+Matrix<Value,4,4> MatrixHelper::pickMatrix(double x, double y, double width, double height, const int viewport[4])
+{
+    // Brings the center of the region to the center of the viewport, and scales the region up to the whole viewport
+    Matrix<Value,4,4> rtn = identity<Value>();
+    rtn(0,0) = static_cast<Value>(viewport[2] / width);
+    rtn(1,1) = static_cast<Value>(viewport[3] / height);
+    rtn(0,3) = static_cast<Value>((viewport[2] - 2 * (x - viewport[0])) / width);
+    rtn(1,3) = static_cast<Value>((viewport[3] - 2 * (y - viewport[1])) / height);
+    return rtn;
+}
+
+
+template <typename Value>
+Quaternion<Value>::Quaternion(Value w, Value x, Value y, Value z)
+: w(w)
+, x(x)
+, y(y)
+, z(z)
+{
+}
+
+template <typename Value>
+Quaternion<Value> Quaternion<Value>::identity()
+{
+    return Quaternion<Value>(1, 0, 0, 0);
+}
+
+template <typename Value>
+Quaternion<Value> Quaternion<Value>::fromAxisAngle(double angle, const Matrix<Value,4,1> &axis)
+{
+    // cos(angle/2) + sin(angle/2) * (x,y,z), where (x,y,z) is normalized
+    // The trigonometry is done in the precision of Value, as it is called for each mouse event
+    Value halfAngle = static_cast<Value>(angle / 2);
+    Value s = std::sin(halfAngle) / static_cast<Value>(axis.norm());
+    return Quaternion<Value>(std::cos(halfAngle), axis(0,0)*s, axis(1,0)*s, axis(2,0)*s);
+}
+
+template <typename Value>
+Quaternion<Value> Quaternion<Value>::operator*(const Quaternion<Value> &b) const
+{
+    // Hamilton product
+    return Quaternion<Value>(w*b.w - x*b.x - y*b.y - z*b.z,
+                             w*b.x + x*b.w + y*b.z - z*b.y,
+                             w*b.y - x*b.z + y*b.w + z*b.x,
+                             w*b.z + x*b.y - y*b.x + z*b.w);
+}
+
+template <typename Value>
+Quaternion<Value> Quaternion<Value>::conjugate() const
+{
+    return Quaternion<Value>(w, -x, -y, -z);
+}
+
+template <typename Value>
+void Quaternion<Value>::normalize()
+{
+    Value n = sqrt(w*w + x*x + y*y + z*z);
+    w /= n;
+    x /= n;
+    y /= n;
+    z /= n;
+}
+
+template <typename Value>
+Matrix<Value,4,1> Quaternion<Value>::rotate(const Matrix<Value,4,1> &vector) const
+{
+    /*
+     * v' = v + w t + u * t, where u = (x,y,z) and t = 2 u * v
+     * Which is cheaper than the q v q* product.
+     */
+    Value vx = vector(0,0), vy = vector(1,0), vz = vector(2,0);
+    Value tx = 2 * (y*vz - z*vy);
+    Value ty = 2 * (z*vx - x*vz);
+    Value tz = 2 * (x*vy - y*vx);
+    Matrix<Value,4,1> rtn;
+    rtn(0,0) = vx + w*tx + (y*tz - z*ty);
+    rtn(1,0) = vy + w*ty + (z*tx - x*tz);
+    rtn(2,0) = vz + w*tz + (x*ty - y*tx);
+    rtn(3,0) = static_cast<Value>(1);
+    return rtn;
+}
+
+template <typename Value>
+Matrix<Value,4,4> Quaternion<Value>::toMatrix() const
+{
+    /*
+     *  / 1-2(y²+z²)   2(xy-wz)    2(xz+wy)   0 \
+     * |   2(xy+wz)   1-2(x²+z²)   2(yz-wx)   0  |
+     * |   2(xz-wy)    2(yz+wx)   1-2(x²+y²)  0  |
+     *  \     0           0           0      1 /
+     */
+    Matrix<Value,4,4> rtn;
+    rtn.fill(static_cast<Value>(0));
+    rtn(0,0) = 1 - 2*(y*y + z*z);
+    rtn(0,1) =     2*(x*y - w*z);
+    rtn(0,2) =     2*(x*z + w*y);
+    rtn(1,0) =     2*(x*y + w*z);
+    rtn(1,1) = 1 - 2*(x*x + z*z);
+    rtn(1,2) =     2*(y*z - w*x);
+    rtn(2,0) =     2*(x*z - w*y);
+    rtn(2,1) =     2*(y*z + w*x);
+    rtn(2,2) = 1 - 2*(x*x + y*y);
+    rtn(3,3) = static_cast<Value>(1);
+    return rtn;
+}
+
+
+/*
+ * SIMD specializations for the single precision 4D transformations.
+ *
+ * The values are kept in the very same column-major order as the generic path,
+ * a column of a 4-lines matrix being exactly one SSE register.
+ * As such matrices are 16-byte aligned (see MatrixAlignment), columns are loaded and stored with aligned accesses.
+ * Each resulting column is accumulated in the same order as the generic triple loop
+ * (starting from 0, then adding the products from the last column of the left operand to the first),
+ * so that the results are bit-identical to the scalar path.
+ * The only exception is when the compiler is allowed to contract the scalar multiply-adds
+ * into FMA instructions (eg. -mfma with the default -ffp-contract=fast),
+ * then both paths may differ by at most 4 ULP of the sum of the absolute values of the accumulated products.
+ */
+#ifdef __SSE__
+
+#include <xmmintrin.h>
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+
+template <>
+template <>
+inline Matrix<float,4,4> Matrix<float,4,4>::operator*(const Matrix<float,4,4> &b) const
+{
+    Matrix<float,4,4> rtn;
+    __m128 a0 = _mm_load_ps(values   );
+    __m128 a1 = _mm_load_ps(values+ 4);
+    __m128 a2 = _mm_load_ps(values+ 8);
+    __m128 a3 = _mm_load_ps(values+12);
+#ifdef __AVX__
+    // Two resulting columns per iteration, each 128-bit lane handling one
+    __m256 a0x2 = _mm256_insertf128_ps(_mm256_castps128_ps256(a0), a0, 1);
+    __m256 a1x2 = _mm256_insertf128_ps(_mm256_castps128_ps256(a1), a1, 1);
+    __m256 a2x2 = _mm256_insertf128_ps(_mm256_castps128_ps256(a2), a2, 1);
+    __m256 a3x2 = _mm256_insertf128_ps(_mm256_castps128_ps256(a3), a3, 1);
+    for (unsigned int c = 0 ; c < 4 ; c += 2) {
+        __m256 bc = _mm256_loadu_ps(b.values+c*4);
+        __m256 acc = _mm256_setzero_ps();
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(a3x2, _mm256_permute_ps(bc, _MM_SHUFFLE(3,3,3,3))));
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(a2x2, _mm256_permute_ps(bc, _MM_SHUFFLE(2,2,2,2))));
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(a1x2, _mm256_permute_ps(bc, _MM_SHUFFLE(1,1,1,1))));
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(a0x2, _mm256_permute_ps(bc, _MM_SHUFFLE(0,0,0,0))));
+        _mm256_storeu_ps(rtn.values+c*4, acc);
+    }
+#else
+    for (unsigned int c = 0 ; c < 4 ; ++c) {
+        const float* bc = b.values+c*4;
+        __m128 acc = _mm_setzero_ps();
+        acc = _mm_add_ps(acc, _mm_mul_ps(a3, _mm_set1_ps(bc[3])));
+        acc = _mm_add_ps(acc, _mm_mul_ps(a2, _mm_set1_ps(bc[2])));
+        acc = _mm_add_ps(acc, _mm_mul_ps(a1, _mm_set1_ps(bc[1])));
+        acc = _mm_add_ps(acc, _mm_mul_ps(a0, _mm_set1_ps(bc[0])));
+        _mm_store_ps(rtn.values+c*4, acc);
+    }
+#endif
+    return rtn;
+}
+
+template <>
+template <>
+inline Matrix<float,4,1> Matrix<float,4,4>::operator*(const Matrix<float,4,1> &b) const
+{
+    Matrix<float,4,1> rtn;
+    __m128 acc = _mm_setzero_ps();
+    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_load_ps(values+12), _mm_set1_ps(b.values[3])));
+    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_load_ps(values+ 8), _mm_set1_ps(b.values[2])));
+    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_load_ps(values+ 4), _mm_set1_ps(b.values[1])));
+    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_load_ps(values   ), _mm_set1_ps(b.values[0])));
+    _mm_store_ps(rtn.values, acc);
+    return rtn;
+}
+
+template <>
+inline Matrix<float,4,1> operator* (Matrix<float,4,1> u, Matrix<float,4,1> v)
+{
+    /*
+     * (u.y, u.z, u.x) * (v.z, v.x, v.y) - (u.z, u.x, u.y) * (v.y, v.z, v.x)
+     * The fourth component cancels out, and is set back to 1 afterwards.
+     */
+    __m128 a = _mm_load_ps(u.values);
+    __m128 b = _mm_load_ps(v.values);
+    __m128 aYZX = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3,0,2,1));
+    __m128 aZXY = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3,1,0,2));
+    __m128 bYZX = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3,0,2,1));
+    __m128 bZXY = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3,1,0,2));
+    Matrix<float,4,1> rtn;
+    _mm_store_ps(rtn.values, _mm_sub_ps(_mm_mul_ps(aYZX, bZXY), _mm_mul_ps(aZXY, bYZX)));
+    rtn.values[3] = 1;
+    return rtn;
+}
+
+template <>
+inline Matrix<float,4,4> MatrixHelper::inverse<float>(const Matrix<float,4,4> &matrix)
+{
+    /*
+     * Cramer's rule, as in Intel's "Streaming SIMD Extensions - Inverse of 4x4 Matrix" (AP-928).
+     * The inverse of the transpose being the transpose of the inverse,
+     * the column-major storage is processed as is.
+     */
+    __m128 minor0, minor1, minor2, minor3;
+    __m128 row0, row1, row2, row3;
+    __m128 det, tmp1;
+    __m128 col0 = _mm_load_ps(matrix.values   );
+    __m128 col1 = _mm_load_ps(matrix.values+ 4);
+    __m128 col2 = _mm_load_ps(matrix.values+ 8);
+    __m128 col3 = _mm_load_ps(matrix.values+12);
+    // Transpose, with the two halves of row1 and row3 swapped
+    tmp1 = _mm_movelh_ps(col0, col1);
+    row1 = _mm_movelh_ps(col2, col3);
+    row0 = _mm_shuffle_ps(tmp1, row1, 0x88);
+    row1 = _mm_shuffle_ps(row1, tmp1, 0xDD);
+    tmp1 = _mm_movehl_ps(col1, col0);
+    row3 = _mm_movehl_ps(col3, col2);
+    row2 = _mm_shuffle_ps(tmp1, row3, 0x88);
+    row3 = _mm_shuffle_ps(row3, tmp1, 0xDD);
+
+    tmp1 = _mm_mul_ps(row2, row3);
+    tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+    minor0 = _mm_mul_ps(row1, tmp1);
+    minor1 = _mm_mul_ps(row0, tmp1);
+    tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+    minor0 = _mm_sub_ps(_mm_mul_ps(row1, tmp1), minor0);
+    minor1 = _mm_sub_ps(_mm_mul_ps(row0, tmp1), minor1);
+    minor1 = _mm_shuffle_ps(minor1, minor1, 0x4E);
+
+    tmp1 = _mm_mul_ps(row1, row2);
+    tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+    minor0 = _mm_add_ps(_mm_mul_ps(row3, tmp1), minor0);
+    minor3 = _mm_mul_ps(row0, tmp1);
+    tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+    minor0 = _mm_sub_ps(minor0, _mm_mul_ps(row3, tmp1));
+    minor3 = _mm_sub_ps(_mm_mul_ps(row0, tmp1), minor3);
+    minor3 = _mm_shuffle_ps(minor3, minor3, 0x4E);
+
+    tmp1 = _mm_mul_ps(_mm_shuffle_ps(row1, row1, 0x4E), row3);
+    tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+    row2 = _mm_shuffle_ps(row2, row2, 0x4E);
+    minor0 = _mm_add_ps(_mm_mul_ps(row2, tmp1), minor0);
+    minor2 = _mm_mul_ps(row0, tmp1);
+    tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+    minor0 = _mm_sub_ps(minor0, _mm_mul_ps(row2, tmp1));
+    minor2 = _mm_sub_ps(_mm_mul_ps(row0, tmp1), minor2);
+    minor2 = _mm_shuffle_ps(minor2, minor2, 0x4E);
+
+    tmp1 = _mm_mul_ps(row0, row1);
+    tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+    minor2 = _mm_add_ps(_mm_mul_ps(row3, tmp1), minor2);
+    minor3 = _mm_sub_ps(_mm_mul_ps(row2, tmp1), minor3);
+    tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+    minor2 = _mm_sub_ps(_mm_mul_ps(row3, tmp1), minor2);
+    minor3 = _mm_sub_ps(minor3, _mm_mul_ps(row2, tmp1));
+
+    tmp1 = _mm_mul_ps(row0, row3);
+    tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+    minor1 = _mm_sub_ps(minor1, _mm_mul_ps(row2, tmp1));
+    minor2 = _mm_add_ps(_mm_mul_ps(row1, tmp1), minor2);
+    tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+    minor1 = _mm_add_ps(_mm_mul_ps(row2, tmp1), minor1);
+    minor2 = _mm_sub_ps(minor2, _mm_mul_ps(row1, tmp1));
+
+    tmp1 = _mm_mul_ps(row0, row2);
+    tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+    minor1 = _mm_add_ps(_mm_mul_ps(row3, tmp1), minor1);
+    minor3 = _mm_sub_ps(minor3, _mm_mul_ps(row1, tmp1));
+    tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+    minor1 = _mm_sub_ps(minor1, _mm_mul_ps(row3, tmp1));
+    minor3 = _mm_add_ps(_mm_mul_ps(row1, tmp1), minor3);
+
+    // Determinant, broadcasted, and exactly divided rather than using the approximate reciprocal
+    det = _mm_mul_ps(row0, minor0);
+    det = _mm_add_ps(_mm_shuffle_ps(det, det, 0x4E), det);
+    det = _mm_add_ps(_mm_shuffle_ps(det, det, 0xB1), det);
+    assert(_mm_cvtss_f32(det) != 0);
+    Matrix<float,4,4> rtn;
+    _mm_store_ps(rtn.values   , _mm_div_ps(minor0, det));
+    _mm_store_ps(rtn.values+ 4, _mm_div_ps(minor1, det));
+    _mm_store_ps(rtn.values+ 8, _mm_div_ps(minor2, det));
+    _mm_store_ps(rtn.values+12, _mm_div_ps(minor3, det));
+    return rtn;
 }
 
+/*
+ * Batched transformations: each register holds the same component of 4 (8 with AVX) consecutive elements,
+ * while each coefficient of the transformation is broadcasted once for the whole batch.
+ * The remaining elements are handled one at a time, with the same accumulation order.
+ */
+#ifdef __AVX__
+#define MATRIX_BATCH_LANES 8
+#define MATRIX_BATCH_REG __m256
+#define MATRIX_BATCH_SET1 _mm256_set1_ps
+#define MATRIX_BATCH_LOAD _mm256_loadu_ps
+#define MATRIX_BATCH_STORE _mm256_storeu_ps
+#define MATRIX_BATCH_ADD _mm256_add_ps
+#define MATRIX_BATCH_MUL _mm256_mul_ps
+#else
+#define MATRIX_BATCH_LANES 4
+#define MATRIX_BATCH_REG __m128
+#define MATRIX_BATCH_SET1 _mm_set1_ps
+#define MATRIX_BATCH_LOAD _mm_loadu_ps
+#define MATRIX_BATCH_STORE _mm_storeu_ps
+#define MATRIX_BATCH_ADD _mm_add_ps
+#define MATRIX_BATCH_MUL _mm_mul_ps
+#endif
+
+template <>
+inline void MatrixHelper::transformBatch<float>(const Matrix<float,4,4> &transformation, std::size_t count,
+                                                const float *x, const float *y, const float *z, float w,
+                                                float *outX, float *outY, float *outZ)
+{
+    const Matrix<float,4,4> &m = transformation;
+    std::size_t i = 0;
+    MATRIX_BATCH_REG cw[3], cz[3], cy[3], cx[3];
+    for (unsigned int l = 0 ; l < 3 ; ++l) {
+        cw[l] = MATRIX_BATCH_SET1(0.0f + m(l,3)*w);
+        cz[l] = MATRIX_BATCH_SET1(m(l,2));
+        cy[l] = MATRIX_BATCH_SET1(m(l,1));
+        cx[l] = MATRIX_BATCH_SET1(m(l,0));
+    }
+    std::size_t batchEnd = count - count % MATRIX_BATCH_LANES;
+    for ( ; i < batchEnd ; i += MATRIX_BATCH_LANES) {
+        MATRIX_BATCH_REG xi = MATRIX_BATCH_LOAD(x+i);
+        MATRIX_BATCH_REG yi = MATRIX_BATCH_LOAD(y+i);
+        MATRIX_BATCH_REG zi = MATRIX_BATCH_LOAD(z+i);
+        float *out[3] = { outX+i, outY+i, outZ+i };
+        for (unsigned int l = 0 ; l < 3 ; ++l) {
+            MATRIX_BATCH_REG acc = cw[l];
+            acc = MATRIX_BATCH_ADD(acc, MATRIX_BATCH_MUL(cz[l], zi));
+            acc = MATRIX_BATCH_ADD(acc, MATRIX_BATCH_MUL(cy[l], yi));
+            acc = MATRIX_BATCH_ADD(acc, MATRIX_BATCH_MUL(cx[l], xi));
+            MATRIX_BATCH_STORE(out[l], acc);
+        }
+    }
+    for ( ; i < count ; ++i) {
+        float xi = x[i], yi = y[i], zi = z[i];
+        outX[i] = 0.0f + m(0,3)*w + m(0,2)*zi + m(0,1)*yi + m(0,0)*xi;
+        outY[i] = 0.0f + m(1,3)*w + m(1,2)*zi + m(1,1)*yi + m(1,0)*xi;
+        outZ[i] = 0.0f + m(2,3)*w + m(2,2)*zi + m(2,1)*yi + m(2,0)*xi;
+    }
+}
+
+template <>
+inline void MatrixHelper::transformBatch<float>(const Matrix<float,4,4> &transformation, std::size_t count,
+                                                const float *x, const float *y, const float *z, const float *w,
+                                                float *outX, float *outY, float *outZ, float *outW)
+{
+    const Matrix<float,4,4> &m = transformation;
+    std::size_t i = 0;
+    MATRIX_BATCH_REG cw[4], cz[4], cy[4], cx[4];
+    for (unsigned int l = 0 ; l < 4 ; ++l) {
+        cw[l] = MATRIX_BATCH_SET1(m(l,3));
+        cz[l] = MATRIX_BATCH_SET1(m(l,2));
+        cy[l] = MATRIX_BATCH_SET1(m(l,1));
+        cx[l] = MATRIX_BATCH_SET1(m(l,0));
+    }
+    std::size_t batchEnd = count - count % MATRIX_BATCH_LANES;
+    for ( ; i < batchEnd ; i += MATRIX_BATCH_LANES) {
+        MATRIX_BATCH_REG xi = MATRIX_BATCH_LOAD(x+i);
+        MATRIX_BATCH_REG yi = MATRIX_BATCH_LOAD(y+i);
+        MATRIX_BATCH_REG zi = MATRIX_BATCH_LOAD(z+i);
+        MATRIX_BATCH_REG wi = MATRIX_BATCH_LOAD(w+i);
+        float *out[4] = { outX+i, outY+i, outZ+i, outW+i };
+        for (unsigned int l = 0 ; l < 4 ; ++l) {
+            MATRIX_BATCH_REG acc = MATRIX_BATCH_MUL(cw[l], wi);
+            acc = MATRIX_BATCH_ADD(acc, MATRIX_BATCH_MUL(cz[l], zi));
+            acc = MATRIX_BATCH_ADD(acc, MATRIX_BATCH_MUL(cy[l], yi));
+            acc = MATRIX_BATCH_ADD(acc, MATRIX_BATCH_MUL(cx[l], xi));
+            MATRIX_BATCH_STORE(out[l], acc);
+        }
+    }
+    for ( ; i < count ; ++i) {
+        float xi = x[i], yi = y[i], zi = z[i], wi = w[i];
+        outX[i] = 0.0f + m(0,3)*wi + m(0,2)*zi + m(0,1)*yi + m(0,0)*xi;
+        outY[i] = 0.0f + m(1,3)*wi + m(1,2)*zi + m(1,1)*yi + m(1,0)*xi;
+        outZ[i] = 0.0f + m(2,3)*wi + m(2,2)*zi + m(2,1)*yi + m(2,0)*xi;
+        outW[i] = 0.0f + m(3,3)*wi + m(3,2)*zi + m(3,1)*yi + m(3,0)*xi;
+    }
+}
+
+#undef MATRIX_BATCH_LANES
+#undef MATRIX_BATCH_REG
+#undef MATRIX_BATCH_SET1
+#undef MATRIX_BATCH_LOAD
+#undef MATRIX_BATCH_STORE
+#undef MATRIX_BATCH_ADD
+#undef MATRIX_BATCH_MUL
+
+#endif /* __SSE__ */
+
 
 
 #endif /* _MATRIX_TCC */
\ No newline at end of file
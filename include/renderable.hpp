@@ -18,9 +18,12 @@
 #define _RENDERABLE_HPP 1
 
 #include <vector>
+#include <map>
+#include <utility>
 #include <GL/gl.h>
 
 #include "matrix.hpp"
+#include "bounds.hpp"
 #include "visitor.hpp"
 #include "any.hpp"
 
@@ -114,6 +117,14 @@ class IRenderable : public Visitable<IRenderable> {
          * @param renderingMode The current value of glRenderMode().
          */
         virtual void deconfigure(GLenum renderingMode);
+        /** @brief Returns the spatial extent of the object, for culling.
+         *
+         * The volume is expressed in the coordinates the object is rendered in,
+         * that is after its own transformation, if any, has been applied.
+         *
+         * Overload if possible, default implementation returns an infinite volume, so that the object is never culled.
+         */
+        virtual BoundingVolume getBounds();
 };
 
 
@@ -164,10 +175,16 @@ class CompositeRenderable : public virtual IRenderable {
         virtual ~CompositeRenderable();
         /** @brief Renders successively all the components, in order.
          *
-         * Calls \link IRenderable::fullRender() \endlink on each component.
+         * Calls \link IRenderable::fullRender() \endlink on each component
+         * that is not culled by the \link FrustumCuller \endlink.
          * @param renderingMode The current value of glRenderMode().
          */
         virtual void render(GLenum renderingMode);
+        /** @brief Merges the volumes of all the components.
+         *
+         * A composite that also transforms must apply its transformation to the merged volume.
+         */
+        virtual BoundingVolume getBounds();
         //! @copydoc Visitable::accept()
         virtual bool accept(HierarchicalVisitor<IRenderable>& visitor);
 };
@@ -245,6 +262,64 @@ class TransformerRenderable : public virtual IRenderable {
 
 
 
+// Forward declaration for QueueableRenderable's describeState()
+struct RenderState;
+/**
+ * @brief A variant of a renderable whose configuration can be described as a \link RenderState \endlink,
+ *        so that it can be flattened into a \link RenderQueue \endlink.
+ *
+ * When rendered through a render queue, \link describeState() \endlink replaces
+ * \link configure() \endlink and \link deconfigure() \endlink:
+ * the queue applies the described state itself, once for all the draw items sharing it.
+ *
+ * A queueable composite only contributes its state, its components being flattened in turn,
+ * so it must not transform.
+ * It may however ask to be drawn as a single leaf instead (see \link isFlattened() \endlink).
+ * A queueable leaf is drawn using \link loadTransform() \endlink, \link render() \endlink
+ * and \link unloadTransform() \endlink, which must leave the OpenGL state as they found it.
+ */
+class QueueableRenderable : public virtual IRenderable {
+    public:
+        QueueableRenderable();
+        virtual ~QueueableRenderable();
+
+        /**
+         * @brief Adds the configuration of this renderable to the inherited state.
+         *
+         * @param state The state inherited from the parents, to be modified in place
+         * @return Whether there is anything to draw.
+         */
+        virtual bool describeState(RenderState& state) = 0;
+        /**
+         * @brief Tells whether the components of this composite are to be flattened in turn.
+         *
+         * Otherwise the composite is queued as a single leaf, carrying the described state.
+         * Ignored for leaves.
+         *
+         * @return True, by default.
+         */
+        virtual bool isFlattened();
+};
+
+
+
+/**
+ * @brief A variant of a renderable whose OpenGL calls depend on the view, such as a level of detail selection.
+ *
+ * Such a renderable must register itself, along with the variant of its calls, with \link CompiledRenderable::dependOnView() \endlink
+ * whenever it renders, so that a display list freezing its calls gets recorded again once the view needs another variant.
+ */
+class ViewDependentRenderable : public virtual IRenderable {
+    public:
+        ViewDependentRenderable();
+        virtual ~ViewDependentRenderable();
+
+        //! @brief Returns the variant of the calls the current view needs, such as a level of detail, the same variant issuing the same calls.
+        virtual unsigned int getViewVariant() = 0;
+};
+
+
+
 /**
  * @brief Pushes a name onto OpenGL name stack (for selection), and renders internal components.
  *
@@ -281,13 +356,16 @@ class SelectableRenderable : public ConfigurerRenderable {
 /**
  * @brief A selectable, composed renderable.
  */
-class SelectableCompositeRenderable : public CompositeRenderable, public SelectableRenderable {
+class SelectableCompositeRenderable : public CompositeRenderable, public SelectableRenderable, public QueueableRenderable {
     public:
         SelectableCompositeRenderable(GLuint name, Any payload)
         : SelectableRenderable(name, payload)
         {}
         virtual ~SelectableCompositeRenderable()
         {}
+        //! @brief Leaves the state unchanged, as names only matter for selection.
+        virtual bool describeState(RenderState& /*state*/)
+        { return true; }
 };
 /**
  * @brief A selectable, leaf renderable.
@@ -304,6 +382,147 @@ class SelectableLeafRenderable : public LeafRenderable, public SelectableRendera
 
 
 
+/**
+ * @brief CPU-side mirror of the OpenGL modelview matrix along the renderables hierarchy.
+ *
+ * The view (camera) matrix is set once per traversal with \link loadView() \endlink.
+ * Each level of the stack then holds the world transformation (from the object to the world coordinates)
+ * of the \link MatrixTransformerRenderable \endlink being rendered, and the corresponding modelview matrix,
+ * which is loaded as is into OpenGL with a single \c glLoadMatrixf(), instead of being composed by the driver.
+ *
+ * Each world transformation is identified by a version number,
+ * so that a node can tell whether its parent world transformation changed since it cached its own.
+ * The root level is the identity world transformation, whose version is always 0.
+ *
+ * The renderables are expected to leave the current matrix mode to \c GL_MODELVIEW.
+ *
+ * While a display list is being recorded (see \link CompiledRenderable \endlink),
+ * the modelview matrix the list will be replayed with is unknown,
+ * so the relative transformations are pushed and multiplied instead.
+ */
+class TransformStack {
+    private:
+        //! @brief A level of the stack.
+        struct Level {
+            //! @brief World transformation.
+            Matrix<float,4,4> world;
+            //! @brief View matrix multiplied by the world transformation.
+            Matrix<float,4,4> modelView;
+            //! @brief Version of the world transformation.
+            unsigned long version;
+            //! @brief Visible space, in world coordinates of this level.
+            Frustum frustum;
+            //! @brief Whether \link #frustum \endlink is up to date with the projection and modelview matrices.
+            bool frustumKnown;
+        };
+        //! @brief Current view matrix.
+        static Matrix<float,4,4> view;
+        //! @brief Current projection matrix.
+        static Matrix<float,4,4> projection;
+        //! @brief Levels of the stack, the root one first.
+        static std::vector<Level> levels;
+        //! @brief Last version number given by \link newVersion() \endlink.
+        static unsigned long lastVersion;
+        //! @brief Whether a display list is being recorded.
+        static bool recording;
+    public:
+        /**
+         * @brief Sets the view matrix, loads it as the OpenGL modelview matrix, and resets the stack to its root level.
+         *
+         * Must be called whenever the camera changes, outside of any renderable traversal.
+         *
+         * @param view The new view matrix
+         */
+        static void loadView(const Matrix<float,4,4>& view);
+        //! @brief Returns the current view matrix.
+        static const Matrix<float,4,4>& getView();
+        //! @brief Returns the current projection matrix.
+        static const Matrix<float,4,4>& getProjection();
+        /**
+         * @brief Sets the projection matrix, only used for culling.
+         *
+         * It must match the OpenGL projection matrix, including any picking region.
+         *
+         * @param projection The new projection matrix
+         */
+        static void setProjection(const Matrix<float,4,4>& projection);
+        //! @brief Returns the visible space of the current level, in its world coordinates, computing it the first time it is needed.
+        static const Frustum& getFrustum();
+        //! @brief Returns the world transformation of the current level.
+        static const Matrix<float,4,4>& getWorld();
+        //! @brief Returns the version of the world transformation of the current level.
+        static unsigned long getWorldVersion();
+        //! @brief Returns a version number never returned before, to identify a newly computed world transformation.
+        static unsigned long newVersion();
+        /**
+         * @brief Enters a new level, and loads its modelview matrix into OpenGL.
+         *
+         * @param world   World transformation of the new level
+         * @param version Version of \a world
+         * @param local   Transformation of the new level relative to the current one,
+         *                only used while recording a display list
+         */
+        static void push(const Matrix<float,4,4>& world, unsigned long version, const Matrix<float,4,4>& local);
+        //! @brief Leaves the current level, and loads back the modelview matrix of the previous one into OpenGL.
+        static void pop();
+        //! @brief Tells whether a display list is being recorded.
+        static bool isRecording();
+        //! @brief Sets whether a display list is being recorded.
+        static void setRecording(bool recording);
+};
+
+
+
+/**
+ * @brief Hierarchical view frustum culling of the renderables.
+ *
+ * Before a renderable gets rendered, its volume (see \link IRenderable::getBounds() \endlink)
+ * is tested against the visible space of the current \link TransformStack \endlink level.
+ * A renderable completely outside is skipped, along with all its components,
+ * and the components of a renderable completely inside are not tested.
+ *
+ * Nothing is culled while a display list is being recorded,
+ * as it may be replayed with another view.
+ */
+class FrustumCuller {
+    private:
+        //! @brief Whether culling is enabled.
+        static bool enabled;
+        //! @brief Whether the renderable being rendered is completely inside of the visible space.
+        static bool inside;
+        //! @brief Number of renderables culled since the beginning of the current frame.
+        static unsigned long culledNodes;
+        //! @brief Number of renderables culled during the last complete frame.
+        static unsigned long lastFrameCulledNodes;
+    public:
+        //! @brief Tells whether culling is enabled.
+        static bool isEnabled();
+        //! @brief Enables or disables culling.
+        static void setEnabled(bool enabled);
+        /**
+         * @brief Tests whether a renderable is outside of the visible space, and counts it if so.
+         *
+         * @param renderable The renderable to test
+         * @param inside     Whether the parent is completely inside of the visible space, in which case nothing is tested.
+         *                   Set to \c true if the renderable turns out to be completely inside.
+         * @return Whether the renderable must be skipped.
+         */
+        static bool isCulled(IRenderable& renderable, bool& inside);
+        /**
+         * @brief Fully renders a renderable, unless it is culled.
+         *
+         * @param renderable    The renderable to render
+         * @param renderingMode The current value of glRenderMode().
+         */
+        static void render(IRenderable& renderable, GLenum renderingMode);
+        //! @brief Ends the current frame, making its number of culled renderables available through \link getCulledNodes() \endlink.
+        static void endFrame();
+        //! @brief Returns the number of renderables culled during the last complete frame, a culled composite counting once.
+        static unsigned long getCulledNodes();
+};
+
+
+
 /**
  * @brief A transformer that pushes modifications to one of OpenGL matrix.
  *
@@ -313,6 +532,11 @@ class SelectableLeafRenderable : public LeafRenderable, public SelectableRendera
  *
  * Please note that this class transforms the current matrix by multiplication,
  * in particular, it does not replace it.
+ *
+ * With the \link #MODELVIEW \endlink mode, the composition is done on the CPU through the \link TransformStack \endlink:
+ * the resulting world transformation is cached, and only computed again when the transformation is changed
+ * (see \link setTransformation() \endlink) or when the world transformation of the parent changed.
+ * The cached world transformation stays available after rendering, for culling and picking.
  */
 class MatrixTransformerRenderable : public TransformerRenderable {
     public:
@@ -328,15 +552,19 @@ class MatrixTransformerRenderable : public TransformerRenderable {
         MatrixMode matrixMode;
         //! @brief Matrix that will multiply the current OpenGL matrix to transform it.
         Matrix<float,4,4> transformation;
+        //! @brief Cached world transformation, the parent world transformation multiplied by \link #transformation \endlink.
+        Matrix<float,4,4> worldTransformation;
+        //! @brief Version of the cached world transformation.
+        unsigned long worldVersion;
+        //! @brief Version of the parent world transformation used to compute the cached one.
+        unsigned long parentWorldVersion;
+        //! @brief Whether \link #transformation \endlink changed since the world transformation was cached.
+        bool worldDirty;
     public:
         //! @brief Constructs a new matrix transformation.
         //! @param transformation   Transformation to apply to OpenGL matrix
         //! @param matrixMode       Specifies which OpenGL matrix mode to transform
-        MatrixTransformerRenderable(Matrix<float,4,4> transformation, MatrixMode matrixMode = MODELVIEW);
-        //! @brief Constructs a new matrix transformation.
-        //! @param transformation   Transformation to apply to OpenGL matrix
-        //! @param matrixMode       Specifies which OpenGL matrix mode to transform
-        MatrixTransformerRenderable(Matrix<float,4,4>& transformation, MatrixMode matrixMode = MODELVIEW);
+        MatrixTransformerRenderable(const Matrix<float,4,4>& transformation, MatrixMode matrixMode = MODELVIEW);
         //! @brief Applies a 3D cartesian coordinate system transformation.
         //! @param offset           New origin
         //! @param axisX            New X axis
@@ -379,6 +607,26 @@ class MatrixTransformerRenderable : public TransformerRenderable {
         MatrixMode getMatrixMode();
         //! @brief Returns the transformation matrix.
         Matrix<float,4,4> getTransformation();
+        /**
+         * @brief Changes the transformation matrix.
+         *
+         * The cached world transformation is marked dirty, only if the transformation actually changed.
+         * @param transformation The new transformation matrix
+         */
+        void setTransformation(const Matrix<float,4,4>& transformation);
+        /**
+         * @brief Returns the inverse of the transformation matrix.
+         *
+         * The transformation must be affine.
+         * @see MatrixHelper::affineInverse()
+         */
+        Matrix<float,4,4> getInverseTransformation();
+        /**
+         * @brief Returns the world transformation, as cached during the last rendering.
+         *
+         * Only meaningful with the \link #MODELVIEW \endlink mode, once rendered.
+         */
+        const Matrix<float,4,4>& getWorldTransformation() const;
 
         //! @brief Pushes the configured mode matrix and transforms it by multiplication with the configured transformation matrix.
         virtual void loadTransform(GLenum renderingMode);
@@ -388,6 +636,90 @@ class MatrixTransformerRenderable : public TransformerRenderable {
 
 
 
+/**
+ * @brief Composite renderable that records its components into display lists, and replays them.
+ *
+ * Wrap a static subtree with it, to avoid walking it and issuing each of its OpenGL calls on every frame.
+ * Each rendering mode (\c GL_RENDER, \c GL_SELECT, \c GL_FEEDBACK) gets its own display list,
+ * recorded the first time the subtree is rendered in that mode, then replayed with a single \c glCallList().
+ *
+ * Everything the subtree decides on the CPU while rendering is frozen into the lists.
+ * Call \link markDirty() \endlink whenever the subtree changes, the lists are then recorded again
+ * the next time they are needed.
+ * They are also recorded again when the world transformation of the parent changes,
+ * so that the world transformations cached by the subtree stay up to date.
+ *
+ * A compiled renderable rendered while another one is recording simply renders its components,
+ * as display lists cannot be nested during their recording.
+ *
+ * The \link ViewDependentRenderable \endlink recorded into a display list are asked on each replay
+ * which variant of their calls the view needs, the list being recorded again if any differs from the recorded one.
+ * When the scene is rendered from several views within a frame (through the breaches),
+ * each view selects its own set of lists with \link setView() \endlink, so that they do not record each other's over again.
+ *
+ * The \link GLStateCache \endlink is invalidated after each replay, as it cannot tell what state the list left.
+ */
+class CompiledRenderable : public CompositeRenderable {
+    private:
+        //! @brief Number of rendering modes.
+        static const unsigned int MODES = 3;
+        //! @brief A display list, for a view and a rendering mode.
+        struct List {
+            //! @brief Name of the display list, 0 until recorded.
+            GLuint name;
+            //! @brief Whether the display list must be recorded again.
+            bool dirty;
+            //! @brief Version of the parent world transformation used while recording the display list.
+            unsigned long parentWorldVersion;
+            //! @brief View dependent renderables recorded into the display list, with the variant of their recorded calls.
+            std::vector< std::pair<ViewDependentRenderable*,unsigned int> > viewDependents;
+
+            //! @brief Creates a display list still to be recorded.
+            List();
+        };
+        //! @brief Display lists, by view and rendering mode.
+        std::map<std::pair<unsigned int,unsigned int>,List> lists;
+        //! @brief View dependent renderables of the display list being recorded, \c NULL if none.
+        static std::vector< std::pair<ViewDependentRenderable*,unsigned int> >* recordingViewDependents;
+        //! @brief Current view, selecting the display lists.
+        static unsigned int view;
+
+        //! @brief Tells whether the current view needs another variant of any view dependent renderable of the given display list.
+        bool isOutdated(const List& list);
+    public:
+        //! @brief Creates a compiled renderable, with a single component.
+        //! @param subtree The subtree to record.
+        CompiledRenderable(IRenderable* subtree);
+        //! @brief Destructor, releasing the display lists.
+        virtual ~CompiledRenderable();
+        // The display lists are owned, and cannot be shared
+        CompiledRenderable(const CompiledRenderable&) = delete;
+        CompiledRenderable& operator=(const CompiledRenderable&) = delete;
+
+        //! @brief Requests all the display lists to be recorded again, before being used next.
+        void markDirty();
+        /**
+         * @brief Registers a renderable whose calls depend on the view, if a display list is being recorded.
+         *
+         * @param renderable The renderable being rendered
+         * @param variant    The variant of the calls it issues
+         */
+        static void dependOnView(ViewDependentRenderable* renderable, unsigned int variant);
+        /**
+         * @brief Selects the display lists to replay, and record, until the next call.
+         *
+         * @param view Number of the view the scene is rendered from, 0 for the main view.
+         */
+        static void setView(unsigned int view);
+
+        /** @brief Replays the display list of the given rendering mode, recording it first if needed.
+         * @param renderingMode The current value of glRenderMode().
+         */
+        virtual void render(GLenum renderingMode);
+};
+
+
+
 /**
  * @brief Represents a texture and its different OpenGL properties.
  */
@@ -465,6 +797,73 @@ class Texture {
 
 
 
+/**
+ * @brief Lighting properties of a surface.
+ *
+ * @see glMaterialfv()
+ */
+struct Material {
+    //! @brief Ambient color
+    GLfloat ambient[4];
+    //! @brief Diffuse color
+    GLfloat diffuse[4];
+    //! @brief Specular color
+    GLfloat specular[4];
+    //! @brief Specular exponent, range [0-128]
+    GLfloat shininess;
+
+    //! @brief Applies the material to both faces.
+    void apply() const;
+};
+
+
+
+/**
+ * @brief OpenGL configuration needed by a \link QueueableRenderable \endlink,
+ *        applied by a \link RenderQueue \endlink.
+ *
+ * The default state is the one expected when nothing is configured:
+ * no blending, no alpha test, all the channels written, no texture, and the material left untouched.
+ */
+struct RenderState {
+    //! @brief Rendering passes, drawn in order.
+    enum Pass {
+        //! @brief Opaque and alpha tested primitives.
+        OPAQUE_PASS,
+        //! @brief Blended primitives, drawn over the opaque ones.
+        BLENDED_PASS
+    };
+    //! @brief Blending modes.
+    enum Blend {
+        //! @brief No blending.
+        NO_BLEND,
+        //! @brief Blending according to the fragment alpha (\c GL_SRC_ALPHA, \c GL_ONE_MINUS_SRC_ALPHA).
+        ALPHA_BLEND,
+        //! @brief Blending according to the framebuffer alpha (\c GL_DST_ALPHA, \c GL_ONE_MINUS_DST_ALPHA).
+        DESTINATION_ALPHA_BLEND
+    };
+
+    //! @brief Rendering pass
+    Pass pass;
+    //! @brief Blending mode
+    Blend blend;
+    //! @brief Fragments whose alpha is not greater are discarded. The alpha test is disabled if negative.
+    GLfloat alphaThreshold;
+    //! @brief Whether the alpha channel of the framebuffer is written.
+    bool writeAlpha;
+    //! @brief Texture to bind, or \link Texture::NO_TEXTURE \endlink.
+    Texture texture;
+    //! @brief Material to apply, or \c NULL to leave the current one.
+    const Material* material;
+    //! @brief Whether the lighting is computed per pixel, see \link PerPixelLighting \endlink.
+    bool perPixelLighting;
+
+    //! @brief Constructs the default state.
+    RenderState();
+};
+
+
+
 /**
  * @brief Configurer renderable that binds the given texture to the OpenGL context.
  *
@@ -493,13 +892,15 @@ class Texturer : public ConfigurerRenderable {
 /**
  * @brief A texturer, composed renderable.
  */
-class TexturerCompositeRenderable : public CompositeRenderable, public Texturer {
+class TexturerCompositeRenderable : public CompositeRenderable, public Texturer, public QueueableRenderable {
     public:
         TexturerCompositeRenderable(const Texture& texture)
         : Texturer(texture)
         {}
         virtual ~TexturerCompositeRenderable()
         {}
+        //! @brief Sets the texture of the state.
+        virtual bool describeState(RenderState& state);
 };
 /**
  * @brief A texturer, leaf renderable.
@@ -556,6 +957,14 @@ struct Rect {
  * and the lightning is performed triangle by triangle,
  * or vertex by vertex when smoothed.
  *
+ * The steps given at construction are the finest level of detail.
+ * When rendering, coarser levels halving the steps are used,
+ * as long as each step still spans at most \link #PIXELS_PER_STEP \endlink pixels on screen,
+ * or a small enough part of the distance to the light (see \link #LIGHT_DISTANCE_PER_STEP \endlink).
+ * Each level is uploaded into its own buffers, the first time it is used.
+ * When the lighting is computed per pixel (see \link PerPixelLighting \endlink),
+ * the last level, a single quad, is always used.
+ *
  * In selection mode, the rectangle is not being tesseled
  * for speed considerations.
  *
@@ -563,32 +972,65 @@ struct Rect {
  * the rectangle vertices coordinates will evolve between 0 and 1,
  * except for Z which will stay 0.
  */
-class TesseledRectangle : public LeafRenderable, public MatrixTransformerRenderable {
+class TesseledRectangle : public LeafRenderable, public MatrixTransformerRenderable, public ViewDependentRenderable {
+    public:
+        //! @brief Number of levels of detail, each one having half the steps of the previous one, except the last one which is a single quad.
+        static const unsigned int LEVELS = 5;
+        //! @brief Maximum on screen length of a step, in pixels, beyond which a finer level is used.
+        static const float PIXELS_PER_STEP;
+        //! @brief Maximum length of a step, relatively to the distance to the light, beyond which a finer level is used.
+        static const float LIGHT_DISTANCE_PER_STEP;
+
     private:
+        //! @brief A tesselated grid, uploaded into buffer objects.
+        struct Mesh {
+            //! @brief Vertex buffer object holding the interleaved positions and texture coordinates, 0 until built.
+            GLuint vertexBuffer;
+            //! @brief Index buffer object holding the triangles.
+            GLuint indexBuffer;
+            //! @brief Number of indices in \link #indexBuffer \endlink.
+            GLsizei indexCount;
+        };
+        //! @brief Position of the light, in world coordinates.
+        static Matrix<float,4,1> lightPosition;
+        //! @brief Height of the viewport, in pixels.
+        static float viewportHeight;
+
         //! @brief Whether this rectangle may be seen from the two sides.
         bool doubleSided;
-        //! @brief Number of steps to take to go along the X axis.
+        //! @brief Number of steps to take to go along the X axis, at the finest level.
         unsigned int xSteps;
-        //! @brief Number of steps to take to go along the Y axis.
+        //! @brief Number of steps to take to go along the Y axis, at the finest level.
         unsigned int ySteps;
         //! @brief Parameter for texturing the rectangle.
         Rect textureOffsetAndSize;
+        //! @brief Grid of each level of detail, the finest first.
+        Mesh meshes[LEVELS];
+        //! @brief Level of detail used during the last rendering.
+        unsigned int level;
+
+        //! @brief Returns the number of steps of the given level, along an axis having the given number of steps at the finest level.
+        static unsigned int getSteps(unsigned int steps, unsigned int level);
+        //! @brief Builds the buffers of the given level of detail.
+        void buildBuffers(unsigned int level);
+        //! @brief Selects the coarsest level of detail that is fine enough for the current view.
+        unsigned int selectLevel();
     protected:
         /** @brief Actual rendering function.
          *
-         * Handles drawing the front and back rectangle by flipping the normals.
-         * @param reverseNormal Whether or not to reverse normals, for correct lightning.
+         * Draws the rectangle once, facing the Z axis.
+         * In \c GL_RENDER mode, the buffers of \link #level \endlink must have been bound by \link render() \endlink.
          * @param renderingMode The current value of glRenderMode().
          */
-        virtual void doRender(GLenum renderingMode, bool reverseNormal);
+        virtual void doRender(GLenum renderingMode);
     public:
         /** @brief Constructs a tesseled rectangle of unit length along the X and Y axis, starting at the origin.
          * @param xSteps                Number of steps to take to go along the X axis.
          * @param ySteps                Number of steps to take to go along the Y axis.
          * @param textureOffsetAndSize  Parameter for texturing the rectangle.
          * @param doubleSided           Whether this rectangle may be seen from the two sides.
-         *                              Involves two drawings and flipping normals for correct lightning.
-         *                              Uses back face culling for proper hiding the hidden side.
+         *                              Disables face culling, and relies on two sided lighting
+         *                              (\c GL_LIGHT_MODEL_TWO_SIDE) for the back side to be correctly lit.
          */
         TesseledRectangle(unsigned int xSteps, unsigned int ySteps, const Rect textureOffsetAndSize, bool doubleSided = true);
         /** @brief Constructs a tesseled rectangle of unit length along the given X and Y axis, starting at the given origin.
@@ -599,16 +1041,40 @@ class TesseledRectangle : public LeafRenderable, public MatrixTransformerRendera
          * @param ySteps                Number of steps to take to go along the Y axis.
          * @param textureOffsetAndSize  Parameter for texturing the rectangle.
          * @param doubleSided           Whether this rectangle may be seen from the two sides.
-         *                              Involves two drawings and flipping normals for correct lightning.
-         *                              Uses back face culling for proper hiding the hidden side.
+         *                              Disables face culling, and relies on two sided lighting
+         *                              (\c GL_LIGHT_MODEL_TWO_SIDE) for the back side to be correctly lit.
          * @see MatrixTransformerRenderable::computeTransformationMatrix
          */
         TesseledRectangle(Matrix<float,4,1> offset, Matrix<float,4,1> axisX, Matrix<float,4,1> axisY, unsigned int xSteps, unsigned int ySteps, const Rect textureOffsetAndSize, bool doubleSided = true);
-        //! @brief Destructor.
+        //! @brief Destructor, releasing the buffers.
         virtual ~TesseledRectangle();
+        // The buffers are owned, and cannot be shared
+        TesseledRectangle(const TesseledRectangle&) = delete;
+        TesseledRectangle& operator=(const TesseledRectangle&) = delete;
 
-        //! @brief Renders the single or double sided, tesseled, (eventually) textured rectangle.
+        /**
+         * @brief Sets the position of the light the levels of detail are selected for.
+         *
+         * @param position The position, in world coordinates
+         */
+        static void setLightPosition(const Matrix<float,4,1>& position);
+        /**
+         * @brief Sets the height of the viewport the levels of detail are selected for.
+         *
+         * @param height The height, in pixels
+         */
+        static void setViewportHeight(float height);
+
+        /** @brief Renders the single or double sided, tesseled, (eventually) textured rectangle.
+         *
+         * In \c GL_RENDER mode, the level of detail is selected, then its tesselated grid is uploaded once
+         * into a vertex and an index buffer, the first time it gets used, and drawn with a single \c glDrawElements(), even when double sided.
+         */
         virtual void render(GLenum renderingMode);
+        //! @brief Returns the level of detail the current view needs.
+        virtual unsigned int getViewVariant();
+        //! @brief Returns the volume of the transformed rectangle.
+        virtual BoundingVolume getBounds();
 };
 
 
@@ -646,6 +1112,8 @@ class RegularPolygon : public LeafRenderable, public MatrixTransformerRenderable
 
         //! @brief Renders the 
         virtual void render(GLenum renderingMode);
+        //! @brief Returns the volume of the transformed polygon.
+        virtual BoundingVolume getBounds();
 };
 
 
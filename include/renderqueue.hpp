@@ -0,0 +1,124 @@
+/**
+ * @file renderqueue.hpp
+ *
+ * @brief Sorted queue of draw items, flattened from renderables.
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2011 Olivier Favre
+ *
+ * This file is part of Breach.
+ *
+ * Licensed under the Simplified BSD License,
+ * for details please see LICENSE file or the website
+ * http://www.opensource.org/licenses/BSD-2-Clause
+ */
+
+#ifndef _RENDERQUEUE_HPP
+#define _RENDERQUEUE_HPP 1
+
+#include <vector>
+#include <stdint.h>
+
+#include "renderable.hpp"
+
+
+
+/**
+ * @brief Flattens renderable trees into draw items, sorts them by state, and submits them.
+ *
+ * Instead of walking the tree and configuring then deconfiguring each node in turn,
+ * the \link QueueableRenderable \endlink nodes are asked to describe the state they need,
+ * and every leaf becomes a draw item carrying the state inherited along its branch.
+ * A queueable composite that is not to be flattened (see \link QueueableRenderable::isFlattened() \endlink)
+ * becomes a draw item too, as if it were a leaf.
+ * The items are then sorted on a 64 bits key, whose fields are, from the most significant:
+ *  - the pass (4 bits),
+ *  - the blending mode (2 bits),
+ *  - whether the alpha test is enabled (1 bit), and whether the alpha channel is masked (1 bit),
+ *  - whether the lighting is computed per pixel (1 bit),
+ *  - the texture (15 bits),
+ *  - the material (16 bits),
+ *  - the insertion order (24 bits), keeping the tree order between items sharing the same state.
+ *
+ * On submission, only the parts of the state that differ from the previous item are applied.
+ *
+ * Any node that cannot be flattened (not queueable, or a queueable composite that transforms)
+ * becomes a single fallback item, rendered as a whole using \link IRenderable::fullRender() \endlink
+ * under its inherited state.
+ * As it may change the OpenGL state behind the queue, the whole state is applied again after it.
+ *
+ * The queue only handles the \c GL_RENDER mode:
+ * selection and feedback still need \link IRenderable::fullRender() \endlink, to get the name stack right.
+ */
+class RenderQueue {
+    private:
+        //! @brief A draw item.
+        struct Item {
+            //! @brief Sort key
+            uint64_t key;
+            //! @brief Renderable to draw
+            IRenderable* renderable;
+            //! @brief Whether the renderable is rendered as a whole, rather than as a flattened leaf.
+            bool fallback;
+            //! @brief State to apply before drawing
+            RenderState state;
+            //! @brief Compares the sort keys.
+            bool operator<(const Item& other) const;
+        };
+        //! @brief The queued items, sorted on submission.
+        std::vector<Item> items;
+        //! @brief The distinct materials of the queued items, whose indices are used in the sort keys.
+        std::vector<const Material*> materials;
+
+        /**
+         * @brief Recursively queues the given renderable, under the given inherited state.
+         *
+         * Renderables outside of the visible space are skipped, see \link FrustumCuller \endlink.
+         *
+         * @param renderable The renderable to queue
+         * @param state      The state inherited from the parents
+         * @param inside     Whether a parent is known to be completely inside of the visible space
+         */
+        void flatten(IRenderable* renderable, RenderState state, bool inside);
+        //! @brief Queues a single item.
+        void push(IRenderable* renderable, const RenderState& state, bool fallback);
+        //! @brief Computes the sort key of the next item, having the given state.
+        uint64_t computeKey(const RenderState& state);
+        /**
+         * @brief Applies a state.
+         *
+         * @param current The state currently applied, or \c NULL to apply everything
+         * @param state   The state to apply
+         */
+        static void apply(const RenderState* current, const RenderState& state);
+
+    public:
+        //! @brief Creates an empty queue.
+        RenderQueue();
+        //! @brief Destructor.
+        virtual ~RenderQueue();
+
+        //! @brief Removes every item, typically before queuing the next frame.
+        void clear();
+        /**
+         * @brief Flattens and queues a renderable tree.
+         *
+         * @param root The root of the tree
+         * @param pass The pass the tree is drawn in
+         */
+        void add(IRenderable* root, RenderState::Pass pass);
+        //! @brief Returns the number of queued items.
+        unsigned int size() const;
+        /**
+         * @brief Sorts and draws the queued items.
+         *
+         * The default \link RenderState \endlink is restored afterwards.
+         * The items stay queued, and can be submitted again.
+         */
+        void submit();
+};
+
+
+
+#endif /* _RENDERQUEUE_HPP */
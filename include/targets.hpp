@@ -26,6 +26,9 @@
 
 
 /** @brief Defines a target.
+ *
+ * A target is a plain value type (no virtual table, trivially copyable),
+ * so that \link ::targets \endlink can be stored and copied as a packed array.
  */
 class Target {
     protected:
@@ -48,8 +51,6 @@ class Target {
          * @param size Diameter of the target
          */
         Target(float x, float y, float z, float size);
-        //! @brief Destructor.
-        virtual ~Target();
 
         //! @brief Returns the X coordinate of the center
         float getX();
@@ -64,6 +65,7 @@ class Target {
         //! @brief Sets the target as hit
         void setHit();
 };
+static_assert(std::is_trivially_copyable<Target>::value, "Target must be trivially copyable");
 
 
 
@@ -74,7 +76,11 @@ class Target {
  *
  * If the target is hit, nothing is rendered.
  */
-class TargetRenderer : public SelectableLeafRenderable {
+class TargetRenderer : public SelectableLeafRenderable, public QueueableRenderable {
+    public:
+        //! @brief Material of the targets
+        static const Material MATERIAL;
+
     protected:
         //! @brief The target to render
         Target& target;
@@ -97,15 +103,80 @@ class TargetRenderer : public SelectableLeafRenderable {
         //! @brief Configures alpha test, material, and disables alpha channel writing, for rendering.
         //!        Simply disables culling, for selection.
         virtual void configure(GLenum renderingMode);
+        //! @brief Sets the alpha test, alpha channel masking and material of the state.
+        //!        Nothing is to be drawn if the target is hit.
+        virtual bool describeState(RenderState& state);
         //! @brief Use a double sided \link TesseledRectangle \endlink for rendering,
         //!        and a \link RegularPolygon \endlink for selection.
         virtual void render(GLenum renderingMode);
+        //! @brief Returns the volume of both the rendering rectangle and the selection polygon,
+        //!        or an empty volume if the target is hit.
+        virtual BoundingVolume getBounds();
         //! @brief Deconfigures the changed OpenGL states
         virtual void deconfigure(GLenum renderingMode);
 };
 
 
 
+/** @brief Renders many targets at once.
+ *
+ * The components are expected to be the \link TargetRenderer \endlink of the given targets.
+ *
+ * In \c GL_RENDER mode, when instancing is available (see \link PerPixelLighting::isInstancingAvailable() \endlink),
+ * the center and size of each target not hit are gathered into an instance buffer,
+ * uploaded again only when they change, and all the targets are drawn
+ * as a single quad lit per pixel, with a single \c glDrawArraysInstanced(), culling disabled.
+ * The targets are then not culled one by one.
+ *
+ * Otherwise, and in particular for selection, the components are rendered one by one,
+ * so that each target still gets its own name.
+ *
+ * Through a \link RenderQueue \endlink, the batch is queued as a single leaf when instanced,
+ * and its components are flattened and queued one by one otherwise.
+ */
+class TargetBatchRenderer : public CompositeRenderable, public QueueableRenderable {
+    protected:
+        //! @brief The targets to render
+        std::vector<Target>& targets;
+        //! @brief Vertex buffer holding the unit square, as interleaved X, Y, Z, S and T values, 0 until built.
+        GLuint vertexBuffer;
+        //! @brief Instance buffer holding the center and size of each target not hit, 0 until built.
+        GLuint instanceBuffer;
+        //! @brief Instances currently uploaded into \link #instanceBuffer \endlink, 4 values each.
+        std::vector<GLfloat> uploadedInstances;
+        //! @brief Instances gathered for the current frame, kept to avoid reallocations.
+        std::vector<GLfloat> instances;
+
+        //! @brief Tells whether the targets are drawn instanced, in the given mode.
+        bool isInstanced(GLenum renderingMode);
+        //! @brief Gathers the targets not hit, and uploads them if they changed.
+        void updateInstances();
+
+    public:
+        //! @brief Constructs a batch renderer for the given targets, without any component.
+        //! @param targets The targets to render
+        TargetBatchRenderer(std::vector<Target>& targets);
+        //! @brief Destructor, releasing the buffers.
+        virtual ~TargetBatchRenderer();
+        // The buffers are owned, and cannot be shared
+        TargetBatchRenderer(const TargetBatchRenderer&) = delete;
+        TargetBatchRenderer& operator=(const TargetBatchRenderer&) = delete;
+
+        //! @brief Configures alpha test, material, and disables alpha channel writing, when instanced.
+        virtual void configure(GLenum renderingMode);
+        //! @brief Sets the alpha test, alpha channel masking and material of the state, when instanced.
+        //!        Nothing is to be drawn if every target is hit.
+        virtual bool describeState(RenderState& state);
+        //! @brief Tells whether the components are queued one by one, that is when not instanced.
+        virtual bool isFlattened();
+        //! @brief Draws all the targets at once when instanced, or renders each component otherwise.
+        virtual void render(GLenum renderingMode);
+        //! @brief Deconfigures the changed OpenGL states, when instanced.
+        virtual void deconfigure(GLenum renderingMode);
+};
+
+
+
 //! @brief The defined targets
 //! @see initTargets()
 extern std::vector<Target> targets;
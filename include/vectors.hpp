@@ -0,0 +1,233 @@
+/**
+ * @file vectors.hpp
+ *
+ * @brief Lightweight single precision 3D and 4D vectors.
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2011 Olivier Favre
+ *
+ * This file is part of Breach.
+ *
+ * Licensed under the Simplified BSD License,
+ * for details please see LICENSE file or the website
+ * http://www.opensource.org/licenses/BSD-2-Clause
+ */
+
+#ifndef _VECTORS_HPP
+#define _VECTORS_HPP 1
+
+#include "matrix.hpp"
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+/**
+ * @brief Storage and elementary operations shared by \link Vec3f \endlink and \link Vec4f \endlink.
+ *
+ * With SSE, a vector is a single register, and is passed around in registers.
+ * Otherwise, it falls back to a plain array of four values.
+ */
+namespace VectorRegister {
+#ifdef __SSE__
+    //! @brief Four single precision lanes.
+    typedef __m128 Type;
+#else
+    //! @brief Four single precision lanes.
+    struct Type { alignas(16) float lanes[4]; };
+#endif
+}
+
+/**
+ * @brief 3D direction or point, with single precision components.
+ *
+ * Compared to a \link Matrix \endlink \c <float,4,1> following the "fourth component is 1" convention,
+ * the fourth lane is always 0, so that it never needs to be cleared before a dot or cross product.
+ * Conversions from and to such a matrix are lossless for the three meaningful components.
+ *
+ * @remarks
+ * The operations are implemented using SSE when available.
+ * \link normalize(const Vec3f&) \endlink then uses an approximate reciprocal square root refined by a Newton-Raphson step,
+ * which is within a few ULP of the exact result, but not necessarily bit-identical to the generic path.
+ */
+class Vec3f {
+    public:
+        /**
+         * @brief Default constructor.
+         *
+         * The components are left uninitialized.
+         */
+        Vec3f() = default;
+        /**
+         * @brief Constructor taking each component.
+         *
+         * @param x First component
+         * @param y Second component
+         * @param z Third component
+         */
+        Vec3f(float x, float y, float z);
+        /**
+         * @brief Constructor converting a 4D vector.
+         *
+         * @param vector A 4D vector, whose last component is ignored.
+         */
+        explicit Vec3f(const Matrix<float,4,1> &vector);
+        /**
+         * @brief Constructor wrapping raw lanes, the last one being 0.
+         */
+        explicit Vec3f(VectorRegister::Type lanes);
+
+        /**
+         * @brief Converts back to a 4D vector.
+         *
+         * @return The same three components, with a last component equal to 1.
+         */
+        Matrix<float,4,1> toMatrix() const;
+
+        //! @brief Returns the first component.
+        float x() const;
+        //! @brief Returns the second component.
+        float y() const;
+        //! @brief Returns the third component.
+        float z() const;
+
+        //! @brief Component-wise addition.
+        Vec3f operator+(const Vec3f &b) const;
+        //! @brief Component-wise subtraction.
+        Vec3f operator-(const Vec3f &b) const;
+        //! @brief Opposite vector.
+        Vec3f operator-() const;
+        //! @brief Multiplication by a scalar.
+        Vec3f operator*(float scalar) const;
+        //! @brief Division by a scalar.
+        Vec3f operator/(float scalar) const;
+
+        //! @brief Raw lanes, the last one being 0.
+        VectorRegister::Type lanes;
+};
+
+/**
+ * @brief 4D vector, with single precision components.
+ *
+ * All four components are meaningful, and take part in every operation.
+ * Conversions from and to a \link Matrix \endlink \c <float,4,1> are lossless.
+ *
+ * @remarks
+ * Same implementation notes as \link Vec3f \endlink.
+ */
+class Vec4f {
+    public:
+        /**
+         * @brief Default constructor.
+         *
+         * The components are left uninitialized.
+         */
+        Vec4f() = default;
+        /**
+         * @brief Constructor taking each component.
+         *
+         * @param x First component
+         * @param y Second component
+         * @param z Third component
+         * @param w Fourth component
+         */
+        Vec4f(float x, float y, float z, float w);
+        /**
+         * @brief Constructor converting a 4D vector.
+         */
+        explicit Vec4f(const Matrix<float,4,1> &vector);
+        /**
+         * @brief Constructor wrapping raw lanes.
+         */
+        explicit Vec4f(VectorRegister::Type lanes);
+
+        /**
+         * @brief Converts back to a 4D vector.
+         */
+        Matrix<float,4,1> toMatrix() const;
+
+        //! @brief Returns the first component.
+        float x() const;
+        //! @brief Returns the second component.
+        float y() const;
+        //! @brief Returns the third component.
+        float z() const;
+        //! @brief Returns the fourth component.
+        float w() const;
+
+        //! @brief Component-wise addition.
+        Vec4f operator+(const Vec4f &b) const;
+        //! @brief Component-wise subtraction.
+        Vec4f operator-(const Vec4f &b) const;
+        //! @brief Opposite vector.
+        Vec4f operator-() const;
+        //! @brief Multiplication by a scalar.
+        Vec4f operator*(float scalar) const;
+        //! @brief Division by a scalar.
+        Vec4f operator/(float scalar) const;
+
+        //! @brief Raw lanes.
+        VectorRegister::Type lanes;
+};
+
+/**
+ * @brief Calculates the dot product of two vectors.
+ *
+ * The products are summed as \f$ (x_a x_b + y_a y_b) + z_a z_b \f$, whatever the implementation.
+ */
+float dot(const Vec3f &a, const Vec3f &b);
+/**
+ * @brief Calculates the dot product of two vectors.
+ *
+ * The products are summed as \f$ (x_a x_b + y_a y_b) + (z_a z_b + w_a w_b) \f$, whatever the implementation.
+ */
+float dot(const Vec4f &a, const Vec4f &b);
+/**
+ * @brief Calculates the vectorial product of two vectors.
+ *
+ * @return The same vector as \link operator*(Matrix<Value,4,1>,Matrix<Value,4,1>) \endlink.
+ */
+Vec3f cross(const Vec3f &a, const Vec3f &b);
+//! @brief Calculates the L2 norm of a vector.
+float length(const Vec3f &v);
+//! @brief Calculates the L2 norm of a vector, including the fourth component.
+float length(const Vec4f &v);
+/**
+ * @brief Scales a vector to unit length.
+ *
+ * @param v A non-null vector.
+ */
+Vec3f normalize(const Vec3f &v);
+/**
+ * @brief Scales a vector to unit length, including the fourth component.
+ *
+ * @param v A non-null vector.
+ */
+Vec4f normalize(const Vec4f &v);
+/**
+ * @brief Linearly interpolates between two vectors.
+ *
+ * @return \f$ a + (b - a) t \f$, which is \a a for \a t = 0 and \a b for \a t = 1.
+ */
+Vec3f lerp(const Vec3f &a, const Vec3f &b, float t);
+/**
+ * @brief Linearly interpolates between two vectors.
+ *
+ * @return \f$ a + (b - a) t \f$, which is \a a for \a t = 0 and \a b for \a t = 1.
+ */
+Vec4f lerp(const Vec4f &a, const Vec4f &b, float t);
+
+
+
+// Vectors must stay as cheap to pass as a single register
+static_assert(std::is_trivially_copyable<Vec3f>::value, "Vec3f must be trivially copyable");
+static_assert(std::is_trivially_copyable<Vec4f>::value, "Vec4f must be trivially copyable");
+static_assert(sizeof(Vec3f) == 16 && alignof(Vec3f) == 16, "Vec3f must be exactly one aligned register");
+static_assert(sizeof(Vec4f) == 16 && alignof(Vec4f) == 16, "Vec4f must be exactly one aligned register");
+
+
+
+#include "vectors.tcc"
+
+#endif /* _VECTORS_HPP */
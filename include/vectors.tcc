@@ -0,0 +1,213 @@
+/**
+ * @file vectors.tcc
+ *
+ * @brief Lightweight single precision 3D and 4D vectors, inline code.
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2011 Olivier Favre
+ *
+ * This file is part of Breach.
+ *
+ * Licensed under the Simplified BSD License,
+ * for details please see LICENSE file or the website
+ * http://www.opensource.org/licenses/BSD-2-Clause
+ */
+
+#ifndef _VECTORS_HPP
+#error You should include vectors.hpp instead of this file directly
+#endif
+
+#ifndef _VECTORS_TCC
+#define _VECTORS_TCC 1
+
+
+
+/*
+ * Elementary lane operations.
+ * Every other operation is written once on top of them,
+ * so that the SSE and generic paths only differ here.
+ */
+namespace VectorRegister {
+#ifdef __SSE__
+    inline Type set(float x, float y, float z, float w) { return _mm_setr_ps(x, y, z, w); }
+    inline Type load(const float values[4]) { return _mm_load_ps(values); }
+    inline void store(Type a, float values[4]) { _mm_store_ps(values, a); }
+    inline Type add(Type a, Type b) { return _mm_add_ps(a, b); }
+    inline Type sub(Type a, Type b) { return _mm_sub_ps(a, b); }
+    inline Type mul(Type a, Type b) { return _mm_mul_ps(a, b); }
+    inline Type mul(Type a, float scalar) { return _mm_mul_ps(a, _mm_set1_ps(scalar)); }
+    inline Type div(Type a, float scalar) { return _mm_div_ps(a, _mm_set1_ps(scalar)); }
+    inline Type neg(Type a) { return _mm_sub_ps(_mm_setzero_ps(), a); }
+    inline float lane(Type a, unsigned int index) { alignas(16) float values[4]; _mm_store_ps(values, a); return values[index]; }
+    //! @brief Sums the four lanes as (0+1)+(2+3), into every lane.
+    inline Type sum(Type a)
+    {
+        a = _mm_add_ps(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(2,3,0,1)));
+        return _mm_add_ps(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(1,0,3,2)));
+    }
+    //! @brief Computes the square root of the first lane.
+    inline float sqrt(Type a) { return _mm_cvtss_f32(_mm_sqrt_ss(a)); }
+    //! @brief Computes the reciprocal square root of each lane, using one Newton-Raphson step: r' = r (3 - a r^2) / 2.
+    inline Type rsqrt(Type a)
+    {
+        Type r = _mm_rsqrt_ps(a);
+        Type ar2 = _mm_mul_ps(_mm_mul_ps(a, r), r);
+        return _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), r), _mm_sub_ps(_mm_set1_ps(3.0f), ar2));
+    }
+    //! @brief Computes (y,z,x,w) of the given lanes.
+    inline Type yzxw(Type a) { return _mm_shuffle_ps(a, a, _MM_SHUFFLE(3,0,2,1)); }
+#else
+    inline Type set(float x, float y, float z, float w) { Type rtn = {{x, y, z, w}}; return rtn; }
+    inline Type load(const float values[4]) { return set(values[0], values[1], values[2], values[3]); }
+    inline void store(Type a, float values[4]) { memcpy(values, a.lanes, sizeof(a.lanes)); }
+    inline Type add(Type a, Type b) { return set(a.lanes[0]+b.lanes[0], a.lanes[1]+b.lanes[1], a.lanes[2]+b.lanes[2], a.lanes[3]+b.lanes[3]); }
+    inline Type sub(Type a, Type b) { return set(a.lanes[0]-b.lanes[0], a.lanes[1]-b.lanes[1], a.lanes[2]-b.lanes[2], a.lanes[3]-b.lanes[3]); }
+    inline Type mul(Type a, Type b) { return set(a.lanes[0]*b.lanes[0], a.lanes[1]*b.lanes[1], a.lanes[2]*b.lanes[2], a.lanes[3]*b.lanes[3]); }
+    inline Type mul(Type a, float scalar) { return set(a.lanes[0]*scalar, a.lanes[1]*scalar, a.lanes[2]*scalar, a.lanes[3]*scalar); }
+    inline Type div(Type a, float scalar) { return set(a.lanes[0]/scalar, a.lanes[1]/scalar, a.lanes[2]/scalar, a.lanes[3]/scalar); }
+    inline Type neg(Type a) { return set(0-a.lanes[0], 0-a.lanes[1], 0-a.lanes[2], 0-a.lanes[3]); }
+    inline float lane(Type a, unsigned int index) { return a.lanes[index]; }
+    //! @brief Sums the four lanes as (0+1)+(2+3), into every lane.
+    inline Type sum(Type a)
+    {
+        float s = (a.lanes[0] + a.lanes[1]) + (a.lanes[2] + a.lanes[3]);
+        return set(s, s, s, s);
+    }
+    //! @brief Computes the square root of the first lane.
+    inline float sqrt(Type a) { return std::sqrt(a.lanes[0]); }
+    //! @brief Computes the reciprocal square root of each lane.
+    inline Type rsqrt(Type a) { return set(1/std::sqrt(a.lanes[0]), 1/std::sqrt(a.lanes[1]), 1/std::sqrt(a.lanes[2]), 1/std::sqrt(a.lanes[3])); }
+    //! @brief Computes (y,z,x,w) of the given lanes.
+    inline Type yzxw(Type a) { return set(a.lanes[1], a.lanes[2], a.lanes[0], a.lanes[3]); }
+#endif
+}
+
+
+
+inline Vec3f::Vec3f(float x, float y, float z)
+: lanes(VectorRegister::set(x, y, z, 0))
+{
+}
+
+inline Vec3f::Vec3f(const Matrix<float,4,1> &vector)
+: lanes(VectorRegister::set(vector.values[0], vector.values[1], vector.values[2], 0))
+{
+}
+
+inline Vec3f::Vec3f(VectorRegister::Type lanes)
+: lanes(lanes)
+{
+}
+
+inline Matrix<float,4,1> Vec3f::toMatrix() const
+{
+    Matrix<float,4,1> rtn;
+    VectorRegister::store(lanes, rtn.values);
+    rtn.values[3] = 1;
+    return rtn;
+}
+
+inline float Vec3f::x() const { return VectorRegister::lane(lanes, 0); }
+inline float Vec3f::y() const { return VectorRegister::lane(lanes, 1); }
+inline float Vec3f::z() const { return VectorRegister::lane(lanes, 2); }
+
+inline Vec3f Vec3f::operator+(const Vec3f &b) const { return Vec3f(VectorRegister::add(lanes, b.lanes)); }
+inline Vec3f Vec3f::operator-(const Vec3f &b) const { return Vec3f(VectorRegister::sub(lanes, b.lanes)); }
+inline Vec3f Vec3f::operator-() const { return Vec3f(VectorRegister::neg(lanes)); }
+inline Vec3f Vec3f::operator*(float scalar) const { return Vec3f(VectorRegister::mul(lanes, scalar)); }
+inline Vec3f Vec3f::operator/(float scalar) const { return Vec3f(VectorRegister::div(lanes, scalar)); }
+
+
+
+inline Vec4f::Vec4f(float x, float y, float z, float w)
+: lanes(VectorRegister::set(x, y, z, w))
+{
+}
+
+inline Vec4f::Vec4f(const Matrix<float,4,1> &vector)
+: lanes(VectorRegister::load(vector.values))
+{
+}
+
+inline Vec4f::Vec4f(VectorRegister::Type lanes)
+: lanes(lanes)
+{
+}
+
+inline Matrix<float,4,1> Vec4f::toMatrix() const
+{
+    Matrix<float,4,1> rtn;
+    VectorRegister::store(lanes, rtn.values);
+    return rtn;
+}
+
+inline float Vec4f::x() const { return VectorRegister::lane(lanes, 0); }
+inline float Vec4f::y() const { return VectorRegister::lane(lanes, 1); }
+inline float Vec4f::z() const { return VectorRegister::lane(lanes, 2); }
+inline float Vec4f::w() const { return VectorRegister::lane(lanes, 3); }
+
+inline Vec4f Vec4f::operator+(const Vec4f &b) const { return Vec4f(VectorRegister::add(lanes, b.lanes)); }
+inline Vec4f Vec4f::operator-(const Vec4f &b) const { return Vec4f(VectorRegister::sub(lanes, b.lanes)); }
+inline Vec4f Vec4f::operator-() const { return Vec4f(VectorRegister::neg(lanes)); }
+inline Vec4f Vec4f::operator*(float scalar) const { return Vec4f(VectorRegister::mul(lanes, scalar)); }
+inline Vec4f Vec4f::operator/(float scalar) const { return Vec4f(VectorRegister::div(lanes, scalar)); }
+
+
+
+// The last lane of a Vec3f being 0, it does not alter the sums
+inline float dot(const Vec3f &a, const Vec3f &b)
+{
+    return VectorRegister::lane(VectorRegister::sum(VectorRegister::mul(a.lanes, b.lanes)), 0);
+}
+
+inline float dot(const Vec4f &a, const Vec4f &b)
+{
+    return VectorRegister::lane(VectorRegister::sum(VectorRegister::mul(a.lanes, b.lanes)), 0);
+}
+
+inline Vec3f cross(const Vec3f &a, const Vec3f &b)
+{
+    /*
+     * Computes (x_a y_b - y_a x_b, y_a z_b - z_a y_b, z_a x_b - x_a z_b, 0)
+     * with only three shuffles, then moves each component to its place.
+     * Each component is the very same difference of products as the generic cross product.
+     */
+    VectorRegister::Type c = VectorRegister::sub(VectorRegister::mul(a.lanes, VectorRegister::yzxw(b.lanes)),
+                                                 VectorRegister::mul(VectorRegister::yzxw(a.lanes), b.lanes));
+    return Vec3f(VectorRegister::yzxw(c));
+}
+
+inline float length(const Vec3f &v)
+{
+    return VectorRegister::sqrt(VectorRegister::sum(VectorRegister::mul(v.lanes, v.lanes)));
+}
+
+inline float length(const Vec4f &v)
+{
+    return VectorRegister::sqrt(VectorRegister::sum(VectorRegister::mul(v.lanes, v.lanes)));
+}
+
+inline Vec3f normalize(const Vec3f &v)
+{
+    return Vec3f(VectorRegister::mul(v.lanes, VectorRegister::rsqrt(VectorRegister::sum(VectorRegister::mul(v.lanes, v.lanes)))));
+}
+
+inline Vec4f normalize(const Vec4f &v)
+{
+    return Vec4f(VectorRegister::mul(v.lanes, VectorRegister::rsqrt(VectorRegister::sum(VectorRegister::mul(v.lanes, v.lanes)))));
+}
+
+inline Vec3f lerp(const Vec3f &a, const Vec3f &b, float t)
+{
+    return a + (b - a) * t;
+}
+
+inline Vec4f lerp(const Vec4f &a, const Vec4f &b, float t)
+{
+    return a + (b - a) * t;
+}
+
+
+
+#endif /* _VECTORS_TCC */
@@ -26,6 +26,9 @@
 
 
 /** @brief Defines a wall.
+ *
+ * A wall is a plain value type (no virtual table, trivially copyable),
+ * so that \link ::walls \endlink can be stored and copied as a packed array.
  */
 class Wall {
     public:
@@ -64,8 +67,6 @@ class Wall {
          * @param textureScale      The world-space to texture-space scaling factor
          */
         Wall(Matrix<float,4,1> corner, Matrix<float,4,1> axisA, Matrix<float,4,1>axisB, float tesselationScale = STANDARD_TESSELATION_SCALE, float textureScale = STANDARD_TEXTURE_SCALE);
-        //! @brief Destructor.
-        virtual ~Wall();
 
         //! @brief Returns the world-space position of the first corner
         Matrix<float,4,1> getCorner() const;
@@ -87,7 +88,21 @@ class Wall {
          * \link projectOnto() \endlink.
          */
         Matrix<float,2,1> inWallCoordinates(Matrix<float,4,1> point) const;
+
+        /** @brief Returns the transformation equivalent to \link projectOnto() \endlink.
+         *
+         * Use it with \link MatrixHelper::transformBatch() \endlink to project many points at once.
+         */
+        Matrix<float,4,4> getProjectionTransformation() const;
+        /** @brief Returns the transformation equivalent to \link inWallCoordinates() \endlink.
+         *
+         * The transformed points have the wall coordinates as their first two components,
+         * and a null third one.
+         * Use it with \link MatrixHelper::transformBatch() \endlink to convert many points at once.
+         */
+        Matrix<float,4,4> getWallCoordinatesTransformation() const;
 };
+static_assert(std::is_trivially_copyable<Wall>::value, "Wall must be trivially copyable");
 
 
 
@@ -101,7 +116,11 @@ class Wall {
  * It should be manager in a parent \link CompositeRenderable \endlink,
  * in order to apply texturing only once, in a batch manner.
  */
-class WallRenderer : public SelectableLeafRenderable {
+class WallRenderer : public SelectableLeafRenderable, public QueueableRenderable {
+    public:
+        //! @brief Material of the walls
+        static const Material MATERIAL;
+
     protected:
         //! @brief Wall to render
         Wall& wall;
@@ -118,8 +137,12 @@ class WallRenderer : public SelectableLeafRenderable {
 
         //! @brief Applies material
         virtual void configure(GLenum renderingMode);
+        //! @brief Sets the material of the state.
+        virtual bool describeState(RenderState& state);
         //! @brief Renders the wall
         virtual void render(GLenum renderingMode);
+        //! @brief Returns the volume of the wall
+        virtual BoundingVolume getBounds();
         //! @brief Deconfigures any changed OpenGL state.
         virtual void deconfigure(GLenum renderingMode);
 };
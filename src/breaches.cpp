@@ -15,6 +15,8 @@
  */
 
 #include "breaches.hpp"
+#include "vectors.hpp"
+#include "glstate.hpp"
 
 using namespace std;
 
@@ -46,27 +48,24 @@ Matrix<float,2,1> Breach::getAdjustedShotPoint(const Wall& wall, const Matrix<fl
     if (y - DEFAULT_BREACH_HEIGHT/2/bNorm < 0) y =     DEFAULT_BREACH_HEIGHT/2/bNorm;
     if (y + DEFAULT_BREACH_HEIGHT/2/bNorm > 1) y = 1 - DEFAULT_BREACH_HEIGHT/2/bNorm;
     if (x < 0 || y < 0) return shotPoint;
-    return Matrix<float,2,1>((float[]){x, y});
+    return Matrix<float,2,1>(x, y);
 }
 
 Matrix<float,4,4> Breach::getTransformationFromWall(const Wall& wall, const Matrix<float,2,1> shotPoint)
 {
-    Matrix<float,4,1> a = wall.getAxisA();
-    Matrix<float,4,1> b = wall.getAxisB();
-    Matrix<float,4,1> c = wall.getCorner();
-    Matrix<float,4,1> z = a * b;
-    z = z / z.norm();
-    Matrix<float,4,1> t = c + a*shotPoint[0] + b*shotPoint[1];
-    a = a / a.norm();
-    b = b / b.norm();
-    Matrix<float,1,4> upT (playerInclinaison.values);
-    upT = upT / upT.norm();
-    a(3,0) = b(3,0) = upT(0,3) = 0; // merely for the following vector product
-    float upA = (upT * a)[0];
-    float upB = (upT * b)[0];
+    Vec3f a (wall.getAxisA());
+    Vec3f b (wall.getAxisB());
+    Vec3f z = normalize(cross(a, b));
+    Vec3f t = Vec3f(wall.getCorner()) + a*shotPoint[0] + b*shotPoint[1];
+    a = normalize(a);
+    b = normalize(b);
+    // The up vector needs no normalization, only the ratio of its coordinates matters
+    Vec3f up (playerInclinaison);
+    float upA = dot(up, a);
+    float upB = dot(up, b);
     a = a * (DEFAULT_BREACH_WIDTH /2);
     b = b * (DEFAULT_BREACH_HEIGHT/2);
-    Matrix<float,4,4> rtn ((float[]){a[0],a[1],a[2],0, b[0],b[1],b[2],0, z[0],z[1],z[2],0, t[0],t[1],t[2],1});
+    Matrix<float,4,4> rtn (a.x(),a.y(),a.z(),0, b.x(),b.y(),b.z(),0, z.x(),z.y(),z.z(),0, t.x(),t.y(),t.z(),1);
     float upAngle = -atan2(upA,upB);
     rtn = rtn * MatrixHelper::rotation(upAngle, MatrixHelper::unitAxisVector<float>(2));
     return rtn;
@@ -107,10 +106,7 @@ Breach::Breach(bool opened, const Wall& wall, Matrix<float,4,1> color, Matrix<fl
 , color(color)
 , shotPoint(shotPoint)
 , transformation(getTransformationFromWall(wall, shotPoint)) //transformation)
-{
-}
-
-Breach::~Breach()
+, inverseTransformation(MatrixHelper::affineInverse(transformation))
 {
 }
 
@@ -139,6 +135,11 @@ Matrix<float,4,4> Breach::getTransformation() const
     return transformation;
 }
 
+Matrix<float,4,4> Breach::getInverseTransformation() const
+{
+    return inverseTransformation;
+}
+
 
 
 BreachRenderer::BreachRenderer(Breach& breach, GLuint name, Texturer& texturer, Texturer& highlightTexturer)
@@ -147,7 +148,7 @@ BreachRenderer::BreachRenderer(Breach& breach, GLuint name, Texturer& texturer,
 , breach(breach)
 , texturer(texturer)
 , highlightTexturer(highlightTexturer)
-, renderRenderable(Matrix<float,4,1>((float[]){1,1,0,0}), MatrixHelper::unitAxisVector<float>(0)*-2, MatrixHelper::unitAxisVector<float>(1)*-2, 10, 10, (Rect){0,0,-1,-1}, false)
+, renderRenderable(Matrix<float,4,1>(1,1,0,0), Matrix<float,4,1>(-2,0,0,1), Matrix<float,4,1>(0,-2,0,1), 10, 10, (Rect){0,0,-1,-1}, false)
 {
 }
 
@@ -157,7 +158,7 @@ BreachRenderer::~BreachRenderer()
 
 void BreachRenderer::loadTransform(GLenum renderingMode)
 {
-    transformation = breach.getTransformation();
+    setTransformation(breach.getTransformation());
     MatrixTransformerRenderable::loadTransform(renderingMode);
 }
 
@@ -167,43 +168,49 @@ void BreachRenderer::render(GLenum renderingMode)
     // Hidden highlight
     {
         highlightTexturer.configure(renderingMode);
-        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_FALSE);
+        GLStateCache::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_FALSE);
         // Draw the outline of the hidden breach
         GLfloat mat_ambiant[] = { 10, 5, 0, 1 }; // FIXME Strange to be obliged to set to a vector not normalized to get the right color!
         GLfloat mat_diffuse[] = { 10, 5, 0, 1 };
-        glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, mat_ambiant);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, mat_diffuse);
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        glEnable(GL_POLYGON_OFFSET_FILL);
+        GLStateCache::materialfv(GL_FRONT_AND_BACK, GL_AMBIENT, mat_ambiant);
+        GLStateCache::materialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, mat_diffuse);
+        GLStateCache::enable(GL_BLEND);
+        GLStateCache::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        GLStateCache::enable(GL_POLYGON_OFFSET_FILL);
         glPolygonOffset(0, -10);
 
         // Appear on top of occulting objects
-        glDisable(GL_CULL_FACE);
-        glDepthFunc(GL_GREATER);
+        GLStateCache::disable(GL_CULL_FACE);
+        GLStateCache::depthFunc(GL_GREATER);
         renderRenderable.fullRender(renderingMode);
-        glDepthFunc(GL_LESS);
+        GLStateCache::depthFunc(GL_LESS);
 
         // Appear directly onto the porting wall (only when seen from the cull face)
-        glEnable(GL_CULL_FACE);
-        glCullFace(GL_FRONT);
+        GLStateCache::enable(GL_CULL_FACE);
+        GLStateCache::cullFace(GL_FRONT);
         renderRenderable.fullRender(renderingMode);
-        glCullFace(GL_BACK);
+        GLStateCache::cullFace(GL_BACK);
 
         glPolygonOffset(0, 0);
-        glDisable(GL_POLYGON_OFFSET_FILL);
-        glDisable(GL_BLEND);
-        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        GLStateCache::disable(GL_POLYGON_OFFSET_FILL);
+        GLStateCache::disable(GL_BLEND);
+        GLStateCache::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
         highlightTexturer.deconfigure(renderingMode);
     } //! Hidden highlight
 }
 
+BoundingVolume BreachRenderer::getBounds()
+{
+    if (!breach.isOpened()) return BoundingVolume();
+    return renderRenderable.getBounds().transform(breach.getTransformation());
+}
+
 
 
 void initBreaches(Texture texture, Texture highlight)
 {
-    breaches.push_back(Breach(Matrix<float,4,1>((float[]){0,0.5,1,1})));
-    breaches.push_back(Breach(Matrix<float,4,1>((float[]){1,0.5,0,1})));
+    breaches.push_back(Breach(Matrix<float,4,1>(0,0.5,1,1)));
+    breaches.push_back(Breach(Matrix<float,4,1>(1,0.5,0,1)));
 
     TexturerCompositeRenderable* breachTexturer = new TexturerCompositeRenderable(texture);
     TexturerCompositeRenderable* breachHighlightTexturer = new TexturerCompositeRenderable(highlight);
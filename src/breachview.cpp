@@ -0,0 +1,581 @@
+/**
+ * @file breachview.cpp
+ *
+ * @brief Renders the scene seen through the breaches, using the stencil buffer.
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2011 Olivier Favre
+ *
+ * This file is part of Breach.
+ *
+ * Licensed under the Simplified BSD License,
+ * for details please see LICENSE file or the website
+ * http://www.opensource.org/licenses/BSD-2-Clause
+ */
+
+#define GL_GLEXT_PROTOTYPES 1
+
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+
+#include "breachview.hpp"
+#include "glstate.hpp"
+
+using namespace std;
+
+
+
+const double BreachView::CLIP_OFFSET = 1e-3;
+const float BreachView::DEFAULT_REPROJECTION_THRESHOLD = 0.5f;
+
+vector<BreachView::Level> BreachView::levels;
+unsigned int BreachView::maxDepth = BreachView::DEFAULT_MAX_DEPTH;
+unsigned int BreachView::depthBudget = ~0u;
+unsigned int BreachView::stencilLimit = 0;
+TexturerCompositeRenderable* BreachView::holeTexturer = NULL;
+GLint BreachView::viewport[4] = { 0, 0, 0, 0 };
+Matrix<float,4,4> BreachView::projection;
+map<vector<size_t>,BreachView::Query> BreachView::queries;
+map<vector<size_t>,unsigned int> BreachView::compiledViews;
+unsigned long BreachView::frame = 0;
+bool BreachView::conditionalRendering = false;
+unsigned long BreachView::skippedViews = 0;
+unsigned long BreachView::lastFrameSkippedViews = 0;
+vector<BreachView::Cache> BreachView::caches;
+bool BreachView::caching = false;
+float BreachView::reprojectionThreshold = BreachView::DEFAULT_REPROJECTION_THRESHOLD;
+unsigned long BreachView::sceneVersion = 0;
+
+void BreachView::init(Texture hole)
+{
+    if (holeTexturer == NULL)
+        holeTexturer = new TexturerCompositeRenderable(hole);
+    GLint bits = 0;
+    glGetIntegerv(GL_STENCIL_BITS, &bits);
+    stencilLimit = bits >= 32 ? ~0u : (1u << bits) - 1;
+    if (bits == 0)
+        fprintf(stderr, "warning: No stencil buffer, the breaches show no view.\n");
+    // Conditional rendering and framebuffer objects are core since OpenGL 3.0
+    int major = 0, minor = 0;
+    sscanf(reinterpret_cast<const char*>(glGetString(GL_VERSION)), "%d.%d", &major, &minor);
+    conditionalRendering = major >= 3;
+    caching = major >= 3;
+}
+
+unsigned int BreachView::getMaxDepth()
+{
+    return maxDepth;
+}
+
+void BreachView::setMaxDepth(unsigned int depth)
+{
+    maxDepth = depth;
+    // The cached views show the nested ones
+    invalidate();
+}
+
+unsigned int BreachView::getDepth()
+{
+    return levels.size();
+}
+
+unsigned int BreachView::getDepthBudget()
+{
+    return depthBudget;
+}
+
+void BreachView::setDepthBudget(unsigned int depth)
+{
+    // The cached views stop at the previous budget, deeper views are to be shown
+    if (min(depth, maxDepth) > min(depthBudget, maxDepth))
+        invalidate();
+    depthBudget = depth;
+}
+
+unsigned long BreachView::getSkippedViews()
+{
+    return lastFrameSkippedViews;
+}
+
+float BreachView::getReprojectionThreshold()
+{
+    return reprojectionThreshold;
+}
+
+void BreachView::setReprojectionThreshold(float pixels)
+{
+    reprojectionThreshold = pixels;
+}
+
+void BreachView::invalidate()
+{
+    sceneVersion++;
+}
+
+const Breach* BreachView::getLinkedBreach(const Breach& breach)
+{
+    size_t linked = (&breach - &breaches[0]) ^ 1;
+    if (!breach.isOpened() || linked >= breaches.size() || !breaches[linked].isOpened())
+        return NULL;
+    return &breaches[linked];
+}
+
+Matrix<float,4,4> BreachView::getLinkTransformation(const Breach& entrance, const Breach& exit)
+{
+    // Half turn around the Y axis of the breaches
+    static const Matrix<float,4,4> halfTurn (-1,0,0,0, 0,1,0,0, 0,0,-1,0, 0,0,0,1);
+    Matrix<float,4,4> rtn = entrance.getTransformation() * halfTurn;
+    return rtn * exit.getInverseTransformation();
+}
+
+void BreachView::drawQuad(const Breach& breach)
+{
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glMultMatrixf(breach.getTransformation().values);
+    glBegin(GL_QUADS);
+    glTexCoord2f(0,0);
+    glVertex3f(-1, -1, 0);
+    glTexCoord2f(1,0);
+    glVertex3f( 1, -1, 0);
+    glTexCoord2f(1,1);
+    glVertex3f( 1,  1, 0);
+    glTexCoord2f(0,1);
+    glVertex3f(-1,  1, 0);
+    glEnd();
+    glPopMatrix();
+}
+
+Matrix<float,4,4> BreachView::getObliqueProjection(const Breach& exit)
+{
+    // The Z axis of the breach is its unit normal, pointing out of the wall, the view being rigid
+    Matrix<float,4,4> modelView = TransformStack::getView() * exit.getTransformation();
+    float plane[4] = { modelView(0,2), modelView(1,2), modelView(2,2), (float)-CLIP_OFFSET };
+    for (unsigned int l = 0 ; l < 3 ; l++)
+        plane[3] -= plane[l] * modelView(l,3);
+    // The viewer, at the origin of the eye coordinates, must be behind the plane
+    if (plane[3] >= 0) return projection;
+
+    // Corner of the frustum opposite to the plane, on the far plane
+    float corner[4] = {
+        ((plane[0] > 0 ? 1 : plane[0] < 0 ? -1 : 0) + projection(0,2)) / projection(0,0),
+        ((plane[1] > 0 ? 1 : plane[1] < 0 ? -1 : 0) + projection(1,2)) / projection(1,1),
+        -1,
+        (1 + projection(2,2)) / projection(2,3)
+    };
+    float scale = 2 / (plane[0] * corner[0] + plane[1] * corner[1] + plane[2] * corner[2] + plane[3] * corner[3]);
+    // The third row is such that Z + W, positive inside the frustum, is proportional to the distance to the plane
+    Matrix<float,4,4> rtn = projection;
+    for (unsigned int c = 0 ; c < 4 ; c++)
+        rtn(2,c) = plane[c] * scale - projection(3,c);
+    return rtn;
+}
+
+void BreachView::loadProjection(const Matrix<float,4,4>& matrix)
+{
+    glMatrixMode(GL_PROJECTION);
+    glLoadMatrixf(matrix.values);
+    glMatrixMode(GL_MODELVIEW);
+    TransformStack::setProjection(matrix);
+}
+
+void BreachView::selectDepth(unsigned int depth)
+{
+    glStencilFunc(GL_EQUAL, depth, ~0u);
+    glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+}
+
+bool BreachView::computeScissor(const Breach& entrance, const GLint* enclosing, GLint* scissor)
+{
+    static const float corners[4][2] = { {-1,-1}, {1,-1}, {1,1}, {-1,1} };
+    Matrix<float,4,4> viewProjection = TransformStack::getProjection() * TransformStack::getView();
+    Matrix<float,4,4> clip = viewProjection * entrance.getTransformation();
+    // Corners outside of each clip plane, the breach being off-screen if all of them are outside of the same one
+    unsigned int outside[6] = { 0, 0, 0, 0, 0, 0 };
+    bool behind = false;
+    float minimum[2] = { 1, 1 }, maximum[2] = { -1, -1 };
+    for (unsigned int c = 0 ; c < 4 ; c++) {
+        float position[4];
+        for (unsigned int l = 0 ; l < 4 ; l++)
+            position[l] = clip(l,0) * corners[c][0] + clip(l,1) * corners[c][1] + clip(l,3);
+        for (unsigned int axis = 0 ; axis < 3 ; axis++) {
+            if (position[axis] < -position[3]) outside[2*axis]++;
+            if (position[axis] >  position[3]) outside[2*axis+1]++;
+        }
+        if (position[3] <= 0) {
+            behind = true;
+            continue;
+        }
+        for (unsigned int axis = 0 ; axis < 2 ; axis++) {
+            minimum[axis] = min(minimum[axis], position[axis] / position[3]);
+            maximum[axis] = max(maximum[axis], position[axis] / position[3]);
+        }
+    }
+    for (unsigned int p = 0 ; p < 6 ; p++)
+        if (outside[p] == 4) return false;
+
+    copy(enclosing, enclosing + 4, scissor);
+    if (!behind) {
+        // From normalized device coordinates to window coordinates, rounding outwards
+        GLint left   = viewport[0] + (GLint)floor((max(minimum[0], -1.f) + 1) / 2 * viewport[2]);
+        GLint right  = viewport[0] + (GLint)ceil ((min(maximum[0],  1.f) + 1) / 2 * viewport[2]);
+        GLint bottom = viewport[1] + (GLint)floor((max(minimum[1], -1.f) + 1) / 2 * viewport[3]);
+        GLint top    = viewport[1] + (GLint)ceil ((min(maximum[1],  1.f) + 1) / 2 * viewport[3]);
+        scissor[0] = max(left, enclosing[0]);
+        scissor[1] = max(bottom, enclosing[1]);
+        scissor[2] = min(right, enclosing[0] + enclosing[2]) - scissor[0];
+        scissor[3] = min(top, enclosing[1] + enclosing[3]) - scissor[1];
+    }
+    return scissor[2] > 0 && scissor[3] > 0;
+}
+
+bool BreachView::isFacingAway(const Breach& breach)
+{
+    // The viewer is at the origin of the eye coordinates
+    Matrix<float,4,4> modelView = TransformStack::getView() * breach.getTransformation();
+    float side = 0;
+    for (unsigned int l = 0 ; l < 3 ; l++)
+        side += modelView(l,2) * modelView(l,3);
+    return side >= 0;
+}
+
+vector<size_t> BreachView::getPath(const Breach& entrance)
+{
+    vector<size_t> path;
+    path.reserve(levels.size() + 1);
+    for (vector<Level>::iterator it = levels.begin() ; it < levels.end() ; it++)
+        path.push_back(it->entrance - &breaches[0]);
+    path.push_back(&entrance - &breaches[0]);
+    return path;
+}
+
+BreachView::Query& BreachView::getQuery(const vector<size_t>& path, bool& occluded)
+{
+    Query& query = queries[path];
+    occluded = false;
+    if (query.name == 0) {
+        glGenQueries(1, &query.name);
+    } else if (query.frame + 1 == frame) {
+        // Only read the result if it is already there, never waiting for it
+        GLuint available = GL_FALSE;
+        glGetQueryObjectuiv(query.name, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == GL_TRUE) {
+            GLuint samples = 0;
+            glGetQueryObjectuiv(query.name, GL_QUERY_RESULT, &samples);
+            occluded = samples == 0;
+        }
+    }
+    query.frame = frame;
+    return query;
+}
+
+void BreachView::unmark(const Breach& entrance, unsigned int depth)
+{
+    selectDepth(depth + 1);
+    glStencilOp(GL_KEEP, GL_KEEP, GL_DECR);
+    GLStateCache::depthFunc(GL_ALWAYS);
+    drawQuad(entrance);
+    GLStateCache::depthFunc(GL_LESS);
+    glDepthMask(GL_TRUE);
+    GLStateCache::enable(GL_LIGHTING);
+    GLStateCache::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    selectDepth(depth);
+}
+
+vector< Matrix<float,4,4> > BreachView::getTransformations()
+{
+    vector< Matrix<float,4,4> > rtn (breaches.size());
+    for (size_t i = 0 ; i < breaches.size() ; i++)
+        if (breaches[i].isOpened())
+            rtn[i] = breaches[i].getTransformation();
+    return rtn;
+}
+
+bool BreachView::isCached(const Breach& entrance, const GLint* scissor)
+{
+    static const float corners[4][2] = { {-1,-1}, {1,-1}, {1,1}, {-1,1} };
+    if (!caching || reprojectionThreshold < 0) return false;
+    const Cache& cache = caches[&entrance - &breaches[0]];
+    if (!cache.valid || cache.sceneVersion != sceneVersion || !equal(viewport, viewport + 4, cache.viewport))
+        return false;
+    if (scissor[0] < cache.scissor[0] || scissor[0] + scissor[2] > cache.scissor[0] + cache.scissor[2]
+     || scissor[1] < cache.scissor[1] || scissor[1] + scissor[3] > cache.scissor[1] + cache.scissor[3])
+        return false;
+    vector< Matrix<float,4,4> > transformations = getTransformations();
+    for (size_t i = 0 ; i < transformations.size() ; i++)
+        if (!equal(transformations[i].values, transformations[i].values + 16, cache.transformations[i].values))
+            return false;
+
+    // Distance, in pixels, between the corners projected now and when the view was rendered
+    Matrix<float,4,4> viewProjection = TransformStack::getProjection() * TransformStack::getView();
+    Matrix<float,4,4> clip = viewProjection * entrance.getTransformation();
+    Matrix<float,4,4> cachedClip = cache.viewProjection * entrance.getTransformation();
+    for (unsigned int c = 0 ; c < 4 ; c++) {
+        float position[4], cachedPosition[4];
+        for (unsigned int l = 0 ; l < 4 ; l++) {
+            position[l] = clip(l,0) * corners[c][0] + clip(l,1) * corners[c][1] + clip(l,3);
+            cachedPosition[l] = cachedClip(l,0) * corners[c][0] + cachedClip(l,1) * corners[c][1] + cachedClip(l,3);
+        }
+        if (position[3] <= 0 || cachedPosition[3] <= 0) return false;
+        float dx = (position[0] / position[3] - cachedPosition[0] / cachedPosition[3]) / 2 * viewport[2];
+        float dy = (position[1] / position[3] - cachedPosition[1] / cachedPosition[3]) / 2 * viewport[3];
+        if (dx * dx + dy * dy > reprojectionThreshold * reprojectionThreshold) return false;
+    }
+    return true;
+}
+
+void BreachView::drawRectangle(const GLint* rectangle, GLuint texture, const GLint* viewport)
+{
+    GLfloat width = viewport[0] + viewport[2], height = viewport[1] + viewport[3];
+    GLfloat left = rectangle[0], right = rectangle[0] + rectangle[2], bottom = rectangle[1], top = rectangle[1] + rectangle[3];
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    glOrtho(0, width, 0, height, -1, 1);
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+    if (texture != 0) {
+        GLStateCache::enable(GL_TEXTURE_2D);
+        GLStateCache::bindTexture(GL_TEXTURE_2D, texture);
+    }
+    glBegin(GL_QUADS);
+    glTexCoord2f(left / width, bottom / height);
+    glVertex2f(left, bottom);
+    glTexCoord2f(right / width, bottom / height);
+    glVertex2f(right, bottom);
+    glTexCoord2f(right / width, top / height);
+    glVertex2f(right, top);
+    glTexCoord2f(left / width, top / height);
+    glVertex2f(left, top);
+    glEnd();
+    if (texture != 0) {
+        GLStateCache::bindTexture(GL_TEXTURE_2D, Texture::NO_TEXTURE.getName());
+        GLStateCache::disable(GL_TEXTURE_2D);
+    }
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glPopMatrix();
+}
+
+void BreachView::fill(const Level& level, unsigned int depth, const Cache* cache)
+{
+    const GLint* scissor = level.scissor;
+    selectDepth(depth + 1);
+    glScissor(scissor[0], scissor[1], scissor[2], scissor[3]);
+    GLStateCache::enable(GL_SCISSOR_TEST);
+    GLStateCache::depthFunc(GL_ALWAYS);
+    GLStateCache::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+    // Part of the hole covered by the cached view, rendered in the same viewport
+    GLint covered[4] = { 0, 0, 0, 0 };
+    if (cache != NULL && cache->valid && equal(viewport, viewport + 4, cache->viewport)) {
+        covered[0] = max(scissor[0], cache->scissor[0]);
+        covered[1] = max(scissor[1], cache->scissor[1]);
+        covered[2] = min(scissor[0] + scissor[2], cache->scissor[0] + cache->scissor[2]) - covered[0];
+        covered[3] = min(scissor[1] + scissor[3], cache->scissor[1] + cache->scissor[3]) - covered[1];
+    }
+    bool any = covered[2] > 0 && covered[3] > 0;
+    if (!any || !equal(covered, covered + 4, scissor)) {
+        // The rest shows the color of the linked breach
+        Matrix<float,4,1> color = level.exit->getColor();
+        glColor4f(color[0], color[1], color[2], 1);
+        drawRectangle(scissor, 0, viewport);
+        glColor4f(1, 1, 1, 1);
+    }
+    if (any)
+        drawRectangle(covered, cache->texture, cache->viewport);
+
+    GLStateCache::colorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    if (levels.empty()) {
+        GLStateCache::disable(GL_SCISSOR_TEST);
+    } else {
+        const GLint* enclosing = levels.back().scissor;
+        glScissor(enclosing[0], enclosing[1], enclosing[2], enclosing[3]);
+    }
+    unmark(*level.entrance, depth);
+}
+
+void BreachView::storeCache(const Level& level)
+{
+    Cache& cache = caches[level.entrance - &breaches[0]];
+    GLsizei width = viewport[0] + viewport[2], height = viewport[1] + viewport[3];
+    bool resized = !cache.valid || cache.viewport[0] + cache.viewport[2] != width || cache.viewport[1] + cache.viewport[3] != height;
+    GLint target = 0;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target);
+    if (cache.framebuffer == 0) {
+        glGenFramebuffers(1, &cache.framebuffer);
+        glGenTextures(1, &cache.texture);
+    }
+    if (resized) {
+        GLStateCache::bindTexture(GL_TEXTURE_2D, cache.texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        GLStateCache::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        GLStateCache::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        GLStateCache::bindTexture(GL_TEXTURE_2D, Texture::NO_TEXTURE.getName());
+    }
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, cache.framebuffer);
+    if (resized)
+        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, cache.texture, 0);
+    // Only the scissor rectangle is copied, at the same window coordinates
+    const GLint* scissor = level.scissor;
+    glBlitFramebuffer(scissor[0], scissor[1], scissor[0] + scissor[2], scissor[1] + scissor[3],
+                      scissor[0], scissor[1], scissor[0] + scissor[2], scissor[1] + scissor[3],
+                      GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target);
+
+    cache.valid = true;
+    copy(viewport, viewport + 4, cache.viewport);
+    copy(scissor, scissor + 4, cache.scissor);
+    cache.viewProjection = level.projection * level.view;
+    cache.transformations = getTransformations();
+    cache.sceneVersion = sceneVersion;
+}
+
+void BreachView::beginFrame()
+{
+    levels.clear();
+    frame++;
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    projection = TransformStack::getProjection();
+    CompiledRenderable::setView(0);
+    if (caches.size() < breaches.size())
+        caches.resize(breaches.size());
+    GLStateCache::enable(GL_STENCIL_TEST);
+    selectDepth(0);
+}
+
+void BreachView::endFrame()
+{
+    GLStateCache::disable(GL_SCISSOR_TEST);
+    GLStateCache::disable(GL_STENCIL_TEST);
+    lastFrameSkippedViews = skippedViews;
+    skippedViews = 0;
+}
+
+bool BreachView::enter(const Breach& entrance)
+{
+    const Breach* exit = getLinkedBreach(entrance);
+    unsigned int depth = getDepth();
+    if (exit == NULL || holeTexturer == NULL || depth >= maxDepth || depth >= stencilLimit)
+        return false;
+    Level level;
+    if (!computeScissor(entrance, levels.empty() ? viewport : levels.back().scissor, level.scissor) || isFacingAway(entrance)) {
+        skippedViews++;
+        return false;
+    }
+    level.view = TransformStack::getView();
+    level.projection = TransformStack::getProjection();
+    level.entrance = &entrance;
+    level.exit = exit;
+    level.conditional = false;
+    level.cached = false;
+    vector<size_t> path = getPath(entrance);
+    bool occluded;
+    Query& query = getQuery(path, occluded);
+
+    // Mark the visible pixels of the hole, nearer than the wall
+    GLStateCache::colorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthMask(GL_FALSE);
+    GLStateCache::disable(GL_LIGHTING);
+    glColor4f(1, 1, 1, 1);
+    holeTexturer->configure(GL_RENDER);
+    GLStateCache::enable(GL_ALPHA_TEST);
+    glAlphaFunc(GL_LESS, 0.5f);
+    GLStateCache::enable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(-1, -1);
+    glStencilOp(GL_KEEP, GL_KEEP, GL_INCR);
+    glBeginQuery(GL_SAMPLES_PASSED, query.name);
+    drawQuad(entrance);
+    glEndQuery(GL_SAMPLES_PASSED);
+    glPolygonOffset(0, 0);
+    GLStateCache::disable(GL_POLYGON_OFFSET_FILL);
+    GLStateCache::disable(GL_ALPHA_TEST);
+    holeTexturer->deconfigure(GL_RENDER);
+
+    if (occluded) {
+        // Give back the pixels marked if the breach just came into sight
+        unmark(entrance, depth);
+        skippedViews++;
+        return false;
+    }
+    if (depth == 0) {
+        if (isCached(entrance, level.scissor)) {
+            // Show the cached view in the marked pixels, over the wall
+            fill(level, depth, &caches[&entrance - &breaches[0]]);
+            return false;
+        }
+        level.cached = caching && reprojectionThreshold >= 0;
+    }
+    if (depth >= depthBudget) {
+        // Out of time for this view, show whatever was last seen through the outermost breaches
+        fill(level, depth, depth == 0 && caching ? &caches[&entrance - &breaches[0]] : NULL);
+        return false;
+    }
+    // Conditional renderings cannot be nested, but an enclosing one already covers this view
+    bool nested = false;
+    for (vector<Level>::iterator it = levels.begin() ; it < levels.end() ; it++)
+        nested = nested || it->conditional;
+    if (conditionalRendering && !nested) {
+        glBeginConditionalRender(query.name, GL_QUERY_NO_WAIT);
+        level.conditional = true;
+    }
+
+    // Push their depth back to the far plane, for the view to be drawn over the wall
+    selectDepth(depth + 1);
+    glScissor(level.scissor[0], level.scissor[1], level.scissor[2], level.scissor[3]);
+    GLStateCache::enable(GL_SCISSOR_TEST);
+    glDepthMask(GL_TRUE);
+    GLStateCache::depthFunc(GL_ALWAYS);
+    glDepthRange(1, 1);
+    drawQuad(entrance);
+    glDepthRange(0, 1);
+    GLStateCache::depthFunc(GL_LESS);
+    GLStateCache::enable(GL_LIGHTING);
+    GLStateCache::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+    // Look out of the linked breach, with display lists of its own as the tesselation depends on the view
+    map<vector<size_t>,unsigned int>::iterator view = compiledViews.find(path);
+    if (view == compiledViews.end())
+        view = compiledViews.insert(make_pair(path, compiledViews.size() + 1)).first;
+    level.compiledView = view->second;
+    CompiledRenderable::setView(level.compiledView);
+    levels.push_back(level);
+    TransformStack::loadView(level.view * getLinkTransformation(entrance, *exit));
+    loadProjection(getObliqueProjection(*exit));
+    return true;
+}
+
+void BreachView::leave()
+{
+    Level level = levels.back();
+    levels.pop_back();
+    unsigned int depth = getDepth();
+    if (level.conditional)
+        glEndConditionalRender();
+    if (level.cached)
+        storeCache(level);
+    TransformStack::loadView(level.view);
+    loadProjection(level.projection);
+    CompiledRenderable::setView(levels.empty() ? 0 : levels.back().compiledView);
+
+    // Restore the depth of the hole, and give its pixels back to the previous depth
+    GLStateCache::colorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    GLStateCache::disable(GL_LIGHTING);
+    GLStateCache::depthFunc(GL_ALWAYS);
+    glStencilOp(GL_KEEP, GL_KEEP, GL_DECR);
+    drawQuad(*level.entrance);
+    GLStateCache::depthFunc(GL_LESS);
+    GLStateCache::enable(GL_LIGHTING);
+    GLStateCache::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    selectDepth(depth);
+    if (levels.empty()) {
+        GLStateCache::disable(GL_SCISSOR_TEST);
+    } else {
+        const GLint* scissor = levels.back().scissor;
+        glScissor(scissor[0], scissor[1], scissor[2], scissor[3]);
+    }
+}
@@ -15,6 +15,7 @@
  */
 
 #include "crosshair.hpp"
+#include "glstate.hpp"
 
 
 
@@ -102,14 +103,14 @@ CrosshairRenderer::~CrosshairRenderer()
 
 void CrosshairRenderer::render(GLenum renderingMode)
 {
-    glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, pointerTexture.getName());
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GLStateCache::enable(GL_TEXTURE_2D);
+    GLStateCache::bindTexture(GL_TEXTURE_2D, pointerTexture.getName());
+    GLStateCache::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    GLStateCache::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    GLStateCache::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+    GLStateCache::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+    GLStateCache::enable(GL_BLEND);
+    GLStateCache::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     glColor4f(1,1,1,1);
     float x = windowWidth/2;
     float y = windowHeight/2;
@@ -130,11 +131,11 @@ void CrosshairRenderer::render(GLenum renderingMode)
     glEnd();
 
     if (crosshair.getBreachCount() > 0) {
-        glBindTexture(GL_TEXTURE_2D, breachTexture.getName());
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+        GLStateCache::bindTexture(GL_TEXTURE_2D, breachTexture.getName());
+        GLStateCache::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        GLStateCache::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        GLStateCache::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+        GLStateCache::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
         float texXs[4] = {0, 1, 1, 0};
         float texYs[4] = {0, 0, 1, 1};
 
@@ -162,8 +163,8 @@ void CrosshairRenderer::render(GLenum renderingMode)
         }
     }
 
-    glDisable(GL_BLEND);
-    glBindTexture(GL_TEXTURE_2D, Texture::NO_TEXTURE.getName());
-    glDisable(GL_TEXTURE_2D);
+    GLStateCache::disable(GL_BLEND);
+    GLStateCache::bindTexture(GL_TEXTURE_2D, Texture::NO_TEXTURE.getName());
+    GLStateCache::disable(GL_TEXTURE_2D);
 }
 
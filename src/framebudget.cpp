@@ -0,0 +1,78 @@
+/**
+ * @file framebudget.cpp
+ *
+ * @brief Adapts the breach recursion to the time available for each frame.
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2011 Olivier Favre
+ *
+ * This file is part of Breach.
+ *
+ * Licensed under the Simplified BSD License,
+ * for details please see LICENSE file or the website
+ * http://www.opensource.org/licenses/BSD-2-Clause
+ */
+
+#include <algorithm>
+
+#include "framebudget.hpp"
+
+using namespace std;
+
+
+
+const double FrameBudget::SMOOTHING = 0.1;
+const double FrameBudget::HEADROOM = 0.6;
+
+double FrameBudget::budget = 1.0 / 60;
+double FrameBudget::frameTime = 0;
+timeval FrameBudget::start = {0,0};
+unsigned int FrameBudget::settling = 0;
+
+double FrameBudget::getBudget()
+{
+    return budget;
+}
+
+void FrameBudget::setBudget(double seconds)
+{
+    budget = seconds;
+}
+
+double FrameBudget::getFrameTime()
+{
+    return frameTime;
+}
+
+void FrameBudget::beginFrame()
+{
+    gettimeofday(&start, NULL);
+}
+
+unsigned int FrameBudget::endFrame(unsigned int depth, unsigned int maxDepth)
+{
+    timeval now;
+    gettimeofday(&now, NULL);
+    double elapsed = (now.tv_sec - start.tv_sec) + (now.tv_usec - start.tv_usec) / 1e6;
+    return addFrame(elapsed, depth, maxDepth);
+}
+
+unsigned int FrameBudget::addFrame(double seconds, unsigned int depth, unsigned int maxDepth)
+{
+    frameTime = frameTime == 0 ? seconds : frameTime + SMOOTHING * (seconds - frameTime);
+    depth = min(depth, maxDepth);
+    if (settling > 0) {
+        settling--;
+        return depth;
+    }
+
+    if (frameTime > budget && depth > 0) {
+        settling = SETTLING_FRAMES;
+        return depth - 1;
+    } else if (frameTime < budget * HEADROOM && depth < maxDepth) {
+        settling = SETTLING_FRAMES;
+        return depth + 1;
+    }
+    return depth;
+}
@@ -0,0 +1,239 @@
+/**
+ * @file glstate.cpp
+ *
+ * @brief Shadowed OpenGL state, to elide redundant state changes.
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2011 Olivier Favre
+ *
+ * This file is part of Breach.
+ *
+ * Licensed under the Simplified BSD License,
+ * for details please see LICENSE file or the website
+ * http://www.opensource.org/licenses/BSD-2-Clause
+ */
+
+#define GL_GLEXT_PROTOTYPES 1
+
+#include <cstring>
+
+#include "glstate.hpp"
+
+using namespace std;
+
+
+
+std::map<GLenum,bool> GLStateCache::capabilities;
+std::map<GLenum,GLuint> GLStateCache::boundTextures;
+std::map<std::pair<GLuint,GLenum>,GLint> GLStateCache::textureParameters;
+std::map<std::pair<GLenum,GLenum>,GLStateCache::MaterialValue> GLStateCache::materials;
+bool GLStateCache::blendFuncKnown = false;
+GLenum GLStateCache::blendSource;
+GLenum GLStateCache::blendDestination;
+bool GLStateCache::blendEquationKnown = false;
+GLenum GLStateCache::blendEquationMode;
+bool GLStateCache::depthFuncKnown = false;
+GLenum GLStateCache::depthFunction;
+bool GLStateCache::colorMaskKnown = false;
+GLboolean GLStateCache::colorMaskValues[4];
+bool GLStateCache::cullFaceKnown = false;
+GLenum GLStateCache::cullFaceMode;
+bool GLStateCache::recording = false;
+unsigned long GLStateCache::elidedCalls = 0;
+unsigned long GLStateCache::lastFrameElidedCalls = 0;
+
+bool GLStateCache::mustForward(bool changes)
+{
+    if (changes || recording)
+        return true;
+    elidedCalls++;
+    return false;
+}
+
+void GLStateCache::enable(GLenum capability)
+{
+    map<GLenum,bool>::iterator it = capabilities.find(capability);
+    if (!mustForward(it == capabilities.end() || !it->second))
+        return;
+    if (!recording)
+        capabilities[capability] = true;
+    glEnable(capability);
+}
+
+void GLStateCache::disable(GLenum capability)
+{
+    map<GLenum,bool>::iterator it = capabilities.find(capability);
+    if (!mustForward(it == capabilities.end() || it->second))
+        return;
+    if (!recording)
+        capabilities[capability] = false;
+    glDisable(capability);
+}
+
+void GLStateCache::bindTexture(GLenum target, GLuint texture)
+{
+    map<GLenum,GLuint>::iterator it = boundTextures.find(target);
+    if (!mustForward(it == boundTextures.end() || it->second != texture))
+        return;
+    if (!recording)
+        boundTextures[target] = texture;
+    glBindTexture(target, texture);
+}
+
+void GLStateCache::texParameteri(GLenum target, GLenum pname, GLint param)
+{
+    map<GLenum,GLuint>::iterator bound = boundTextures.find(target);
+    if (bound == boundTextures.end()) {
+        // The modified texture is unknown, the parameter cannot be tracked
+        glTexParameteri(target, pname, param);
+        return;
+    }
+    pair<GLuint,GLenum> key (bound->second, pname);
+    map<pair<GLuint,GLenum>,GLint>::iterator it = textureParameters.find(key);
+    if (!mustForward(it == textureParameters.end() || it->second != param))
+        return;
+    if (!recording)
+        textureParameters[key] = param;
+    glTexParameteri(target, pname, param);
+}
+
+bool GLStateCache::updateMaterial(GLenum face, GLenum pname, const MaterialValue& value)
+{
+    pair<GLenum,GLenum> key (face, pname);
+    map<pair<GLenum,GLenum>,MaterialValue>::iterator it = materials.find(key);
+    if (it != materials.end() && memcmp(it->second.values, value.values, sizeof(value.values)) == 0)
+        return false;
+    if (!recording)
+        materials[key] = value;
+    return true;
+}
+
+void GLStateCache::materialfv(GLenum face, GLenum pname, const GLfloat* params)
+{
+    MaterialValue value = {{ 0, 0, 0, 0 }};
+    switch (pname) {
+        case GL_SHININESS:
+            memcpy(value.values, params, 1 * sizeof(GLfloat));
+            break;
+        case GL_COLOR_INDEXES:
+            memcpy(value.values, params, 3 * sizeof(GLfloat));
+            break;
+        default:
+            memcpy(value.values, params, 4 * sizeof(GLfloat));
+            break;
+    }
+
+    bool changes = false;
+    // Both faces and both properties must be updated, no short-circuit
+    GLenum faces[] = { GL_FRONT, GL_BACK };
+    for (unsigned int f = 0 ; f < 2 ; f++) {
+        if (face != GL_FRONT_AND_BACK && face != faces[f])
+            continue;
+        if (pname == GL_AMBIENT_AND_DIFFUSE) {
+            changes = updateMaterial(faces[f], GL_AMBIENT, value) | changes;
+            changes = updateMaterial(faces[f], GL_DIFFUSE, value) | changes;
+        } else
+            changes = updateMaterial(faces[f], pname, value) | changes;
+    }
+
+    if (!mustForward(changes))
+        return;
+    glMaterialfv(face, pname, params);
+}
+
+void GLStateCache::materialf(GLenum face, GLenum pname, GLfloat param)
+{
+    materialfv(face, pname, &param);
+}
+
+void GLStateCache::blendFunc(GLenum sfactor, GLenum dfactor)
+{
+    if (!mustForward(!blendFuncKnown || blendSource != sfactor || blendDestination != dfactor))
+        return;
+    if (!recording) {
+        blendFuncKnown = true;
+        blendSource = sfactor;
+        blendDestination = dfactor;
+    }
+    glBlendFunc(sfactor, dfactor);
+}
+
+void GLStateCache::blendEquation(GLenum mode)
+{
+    if (!mustForward(!blendEquationKnown || blendEquationMode != mode))
+        return;
+    if (!recording) {
+        blendEquationKnown = true;
+        blendEquationMode = mode;
+    }
+    glBlendEquation(mode);
+}
+
+void GLStateCache::depthFunc(GLenum func)
+{
+    if (!mustForward(!depthFuncKnown || depthFunction != func))
+        return;
+    if (!recording) {
+        depthFuncKnown = true;
+        depthFunction = func;
+    }
+    glDepthFunc(func);
+}
+
+void GLStateCache::colorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha)
+{
+    GLboolean values[] = { red, green, blue, alpha };
+    if (!mustForward(!colorMaskKnown || memcmp(colorMaskValues, values, sizeof(values)) != 0))
+        return;
+    if (!recording) {
+        colorMaskKnown = true;
+        memcpy(colorMaskValues, values, sizeof(values));
+    }
+    glColorMask(red, green, blue, alpha);
+}
+
+void GLStateCache::cullFace(GLenum mode)
+{
+    if (!mustForward(!cullFaceKnown || cullFaceMode != mode))
+        return;
+    if (!recording) {
+        cullFaceKnown = true;
+        cullFaceMode = mode;
+    }
+    glCullFace(mode);
+}
+
+void GLStateCache::invalidate()
+{
+    capabilities.clear();
+    boundTextures.clear();
+    textureParameters.clear();
+    materials.clear();
+    blendFuncKnown = false;
+    blendEquationKnown = false;
+    depthFuncKnown = false;
+    colorMaskKnown = false;
+    cullFaceKnown = false;
+}
+
+bool GLStateCache::isRecording()
+{
+    return recording;
+}
+
+void GLStateCache::setRecording(bool recording)
+{
+    GLStateCache::recording = recording;
+}
+
+void GLStateCache::endFrame()
+{
+    lastFrameElidedCalls = elidedCalls;
+    elidedCalls = 0;
+}
+
+unsigned long GLStateCache::getElidedCalls()
+{
+    return lastFrameElidedCalls;
+}
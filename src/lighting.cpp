@@ -0,0 +1,250 @@
+/**
+ * @file lighting.cpp
+ *
+ * @brief Per pixel lighting, using a GLSL program.
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2011 Olivier Favre
+ *
+ * This file is part of Breach.
+ *
+ * Licensed under the Simplified BSD License,
+ * for details please see LICENSE file or the website
+ * http://www.opensource.org/licenses/BSD-2-Clause
+ */
+
+#define GL_GLEXT_PROTOTYPES 1
+
+#include <cstdio>
+#include <vector>
+
+#include "lighting.hpp"
+
+using namespace std;
+
+
+
+//! @brief Passes the eye coordinates position and normal, and the texture coordinates.
+static const char* VERTEX_SHADER =
+    "#version 120\n"
+    "varying vec3 position;\n"
+    "varying vec3 normal;\n"
+    "void main() {\n"
+    "    position = vec3(gl_ModelViewMatrix * gl_Vertex);\n"
+    "    normal = gl_NormalMatrix * gl_Normal;\n"
+    "    gl_TexCoord[0] = gl_TextureMatrix[0] * gl_MultiTexCoord0;\n"
+    "    gl_Position = ftransform();\n"
+    "}\n";
+
+//! @brief Places and scales a unit square per instance, then passes the same as \link VERTEX_SHADER \endlink.
+static const char* INSTANCED_VERTEX_SHADER =
+    "#version 120\n"
+    "attribute vec4 instance;\n"
+    "varying vec3 position;\n"
+    "varying vec3 normal;\n"
+    "void main() {\n"
+    "    vec4 vertex = vec4(instance.xyz + vec3(gl_Vertex.xy - vec2(0.5), 0.0) * instance.w, 1.0);\n"
+    "    position = vec3(gl_ModelViewMatrix * vertex);\n"
+    "    normal = gl_NormalMatrix * gl_Normal;\n"
+    "    gl_TexCoord[0] = gl_TextureMatrix[0] * gl_MultiTexCoord0;\n"
+    "    gl_Position = gl_ModelViewProjectionMatrix * vertex;\n"
+    "}\n";
+
+//! @brief Lights the fragment the same way the fixed function pipeline lights a vertex, then modulates the texture.
+static const char* FRAGMENT_SHADER =
+    "#version 120\n"
+    "uniform sampler2D image;\n"
+    "varying vec3 position;\n"
+    "varying vec3 normal;\n"
+    "void main() {\n"
+    "    // Two sided lighting, the material being the same for both faces\n"
+    "    vec3 n = normalize(gl_FrontFacing ? normal : -normal);\n"
+    "    vec4 light = gl_LightSource[0].position;\n"
+    "    vec3 toLight = light.xyz - position * light.w;\n"
+    "    float distance = length(toLight);\n"
+    "    vec3 l = toLight / distance;\n"
+    "    float attenuation = 1.0;\n"
+    "    if (light.w != 0.0)\n"
+    "        attenuation = 1.0 / (gl_LightSource[0].constantAttenuation\n"
+    "                           + gl_LightSource[0].linearAttenuation * distance\n"
+    "                           + gl_LightSource[0].quadraticAttenuation * distance * distance);\n"
+    "    float diffuse = max(dot(n, l), 0.0);\n"
+    "    vec4 lit = gl_FrontMaterial.ambient * gl_LightSource[0].ambient\n"
+    "             + diffuse * gl_FrontMaterial.diffuse * gl_LightSource[0].diffuse;\n"
+    "    if (diffuse > 0.0) {\n"
+    "        // Local viewer, at the origin of the eye coordinates\n"
+    "        float specular = dot(n, normalize(l - normalize(position)));\n"
+    "        if (specular > 0.0)\n"
+    "            lit += pow(specular, gl_FrontMaterial.shininess) * gl_FrontMaterial.specular * gl_LightSource[0].specular;\n"
+    "    }\n"
+    "    vec4 color = gl_FrontMaterial.emission + gl_FrontMaterial.ambient * gl_LightModel.ambient + attenuation * lit;\n"
+    "    color = clamp(color, 0.0, 1.0);\n"
+    "    color.a = gl_FrontMaterial.diffuse.a;\n"
+    "    gl_FragColor = color * texture2D(image, gl_TexCoord[0].st);\n"
+    "}\n";
+
+
+
+GLuint PerPixelLighting::program = 0;
+GLuint PerPixelLighting::instancedProgram = 0;
+GLint PerPixelLighting::instanceAttribute = -1;
+bool PerPixelLighting::enabled = true;
+bool PerPixelLighting::bound = false;
+
+GLuint PerPixelLighting::compile(GLenum type, const char* source)
+{
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+    GLint status = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (status != GL_TRUE) {
+        GLint length = 0;
+        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+        if (length < 1) length = 1;
+        vector<char> log (length, '\0');
+        glGetShaderInfoLog(shader, length, NULL, log.data());
+        fprintf(stderr, "error: Cannot compile the per pixel lighting shader:\n%s\n", log.data());
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+GLuint PerPixelLighting::link(const char* vertexSource, const char* fragmentSource)
+{
+    GLuint vertexShader = compile(GL_VERTEX_SHADER, vertexSource);
+    GLuint fragmentShader = compile(GL_FRAGMENT_SHADER, fragmentSource);
+    if (vertexShader == 0 || fragmentShader == 0) {
+        if (vertexShader != 0) glDeleteShader(vertexShader);
+        if (fragmentShader != 0) glDeleteShader(fragmentShader);
+        return 0;
+    }
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glLinkProgram(program);
+    // Flagged for deletion along with the program
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+        GLint length = 0;
+        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+        if (length < 1) length = 1;
+        vector<char> log (length, '\0');
+        glGetProgramInfoLog(program, length, NULL, log.data());
+        fprintf(stderr, "error: Cannot link the per pixel lighting program:\n%s\n", log.data());
+        glDeleteProgram(program);
+        return 0;
+    }
+    // The texture is always read from the first unit
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "image"), 0);
+    glUseProgram(0);
+    return program;
+}
+
+bool PerPixelLighting::init()
+{
+    if (program != 0) return true;
+    // GLSL needs OpenGL 2.0, which is the first version to know this string
+    if (glGetString(GL_SHADING_LANGUAGE_VERSION) == NULL) {
+        glGetError();
+        fprintf(stderr, "warning: GLSL is not supported, lighting per vertex.\n");
+        return false;
+    }
+    program = link(VERTEX_SHADER, FRAGMENT_SHADER);
+    if (program == 0) return false;
+    // Instanced arrays are core since OpenGL 3.3
+    int major = 0, minor = 0;
+    sscanf(reinterpret_cast<const char*>(glGetString(GL_VERSION)), "%d.%d", &major, &minor);
+    if (major > 3 || (major == 3 && minor >= 3)) {
+        instancedProgram = link(INSTANCED_VERTEX_SHADER, FRAGMENT_SHADER);
+        if (instancedProgram != 0)
+            instanceAttribute = glGetAttribLocation(instancedProgram, "instance");
+    }
+    return true;
+}
+
+bool PerPixelLighting::isAvailable()
+{
+    return program != 0;
+}
+
+bool PerPixelLighting::isEnabled()
+{
+    return enabled;
+}
+
+void PerPixelLighting::setEnabled(bool enabled)
+{
+    PerPixelLighting::enabled = enabled;
+}
+
+bool PerPixelLighting::isBound()
+{
+    return bound;
+}
+
+void PerPixelLighting::bind()
+{
+    if (bound || program == 0 || !enabled) return;
+    glUseProgram(program);
+    bound = true;
+}
+
+void PerPixelLighting::unbind()
+{
+    if (!bound) return;
+    glUseProgram(0);
+    bound = false;
+}
+
+bool PerPixelLighting::isInstancingAvailable()
+{
+    return instancedProgram != 0 && enabled;
+}
+
+GLint PerPixelLighting::bindInstanced()
+{
+    glUseProgram(instancedProgram);
+    return instanceAttribute;
+}
+
+void PerPixelLighting::unbindInstanced()
+{
+    glUseProgram(bound ? program : 0);
+}
+
+
+
+PerPixelLightingCompositeRenderable::PerPixelLightingCompositeRenderable(IRenderable* component)
+: CompositeRenderable()
+{
+    components.push_back(component);
+}
+
+PerPixelLightingCompositeRenderable::~PerPixelLightingCompositeRenderable()
+{
+}
+
+void PerPixelLightingCompositeRenderable::configure(GLenum renderingMode)
+{
+    if (renderingMode == GL_RENDER)
+        PerPixelLighting::bind();
+}
+
+bool PerPixelLightingCompositeRenderable::describeState(RenderState& state)
+{
+    state.perPixelLighting = true;
+    return true;
+}
+
+void PerPixelLightingCompositeRenderable::deconfigure(GLenum renderingMode)
+{
+    if (renderingMode == GL_RENDER)
+        PerPixelLighting::unbind();
+}
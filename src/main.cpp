@@ -24,6 +24,8 @@
 #include <GL/freeglut_ext.h>
 
 #include <iostream>
+#include <cstdarg>
+#include <cstdio>
 #include <png.h>
 #include <cmath>
 #include <sys/time.h>
@@ -39,6 +41,11 @@ using namespace std;
 #include "breaches.hpp"
 #include "selection.hpp"
 #include "crosshair.hpp"
+#include "glstate.hpp"
+#include "renderqueue.hpp"
+#include "lighting.hpp"
+#include "breachview.hpp"
+#include "framebudget.hpp"
 
 /*! \def MIN(a,b)
  * @brief A macro that returns the minimum of \a a and \a b.
@@ -76,6 +83,13 @@ Crosshair crosshair;
 //! @brief The crosshair renderer, for the 2D overlay
 CrosshairRenderer* crosshairRenderer = NULL;
 
+//! @brief Queue drawing the targets and breaches sorted by state
+RenderQueue renderQueue;
+
+//! @brief Position of the light, in world coordinates
+GLfloat lightPosition[] = { 0, 0, 0, 1 };
+//GLfloat lightPosition[] = { playerPosition[0], playerPosition[1], playerPosition[2], 1 }; // the player sheds its own light
+
 // Windowing stuff
 //! @brief Scale used for passing to pixels to OpenGL unit
 float pixelToUnitScale;
@@ -100,12 +114,19 @@ float playerSpeed = .01f;
  * Used to control how much to rotate at each mousewheel step.
  */
 float playerInclinaisonSpeed = .1f;
-//! @brief Player looking direction
-Matrix<float,4,1> playerLookAt ((float[4]){0, 0, -1, 1});
+/** @brief Player orientation.
+ *
+ * Rotates the player local frame, looking towards -Z with Y as up, into the world.
+ * Mouse events only compose rotations onto it,
+ * the player basis being derived once per frame by \link updatePlayerBasis() \endlink.
+ */
+Quaternion<float> playerOrientation = Quaternion<float>::identity();
+//! @brief Player looking direction, derived from \link playerOrientation \endlink
+Matrix<float,4,1> playerLookAt (0, 0, -1, 1);
 //! @brief Player position
-Matrix<float,4,1> playerPosition ((float[4]){0, 0, .75f, 1});
-//! @brief Player inclinaison vector (towards the current up)
-Matrix<float,4,1> playerInclinaison ((float[4]){0, 1, 0, 1});
+Matrix<float,4,1> playerPosition (0, 0, .75f, 1);
+//! @brief Player inclinaison vector (towards the current up), derived from \link playerOrientation \endlink
+Matrix<float,4,1> playerInclinaison (0, 1, 0, 1);
 /** @brief Player moving directions.
  *
  * One value per axis.
@@ -117,124 +138,79 @@ int playerAdvance[3] = {0, 0, 0};
 
 
 
+/**
+ * @brief Derives \link playerLookAt \endlink and \link playerInclinaison \endlink from \link playerOrientation \endlink.
+ *
+ * Called once before using the player basis, rather than at each mouse event.
+ */
+void updatePlayerBasis() {
+    static constexpr Matrix<float,4,1> localLookAt (0, 0, -1, 1);
+    static constexpr Matrix<float,4,1> localInclinaison (0, 1, 0, 1);
+    playerLookAt = playerOrientation.rotate(localLookAt);
+    playerInclinaison = playerOrientation.rotate(localInclinaison);
+}
+
+/**
+ * @brief Places the light in the current view.
+ *
+ * The light position is transformed by the modelview matrix at the time it is given,
+ * so that it has to be given again whenever the view changes.
+ */
+void placeLight() {
+    glLightfv(GL_LIGHT0, GL_POSITION, lightPosition);
+}
+
 /**
  * @brief Renders the scene primitives.
  *
+ * The scene seen through each opened breach is rendered recursively inside its hole,
+ * after the opaque primitives that may hide it (see \link BreachView \endlink).
+ *
  * @param forSelection Whether the scene should be rendered for selection test
  *                     using names, or for normal rendering using colors.
  */
 void draw_scene(bool forSelection = false) {
-    if (!forSelection) {
-
-        if (breaches[0].isOpened() || breaches[1].isOpened()) {
-
-            // Test fake far scene (simply draw a target behind the wall)
-            GLfloat mat_ambiant[] = { 1, 1, 1, 1 };
-            GLfloat mat_diffuse[] = { 1, 1, 1, 1 };
-            glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, mat_ambiant);
-            glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, mat_diffuse);
-            glColor4f(1.0, 1.0, 1.0, 1.0);
-            glEnable(GL_TEXTURE_2D);
-            glEnable(GL_BLEND);
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-            glEnable(GL_ALPHA_TEST);
-            glAlphaFunc(GL_GREATER, 0.75f);
-            glBindTexture(GL_TEXTURE_2D, target_texture);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            float x = 0, y = 0, z = -3, size = 1.9/2;
-            glBegin(GL_QUADS);
-            glNormal3f(0, 0, 1);
-            glTexCoord2f(0.0f, 0.0f);
-            glVertex3f(x-size, y-size, z);
-            glTexCoord2f(1.0f, 0.0f);
-            glVertex3f(x+size, y-size, z);
-            glTexCoord2f(1.0f, 1.0f);
-            glVertex3f(x+size, y+size, z);
-            glTexCoord2f(0.0f, 1.0f);
-            glVertex3f(x-size, y=size, z);
-            glEnd();
-            glDisable(GL_ALPHA_TEST);
-            glDisable(GL_BLEND);
+    FrustumCuller::render(*wallsRenderer, forSelection ? GL_SELECT : GL_RENDER);
 
-        }
-    }
-    // Make the framebuffer all opaque
-    glColor4f(0,0,0,1);
-    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_TRUE);
-    glClear(GL_COLOR_BUFFER_BIT);
-    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-    if (!forSelection) {
-        for (std::vector<Breach>::iterator it = breaches.begin() ; it < breaches.end() ; it++) {
-            if (it->isOpened()) {
-                // Draw breach in alpha only, minimizing opacity for better superposition
-                glClear(GL_DEPTH_BUFFER_BIT);
-                glEnable(GL_TEXTURE_2D);
-                glBindTexture(GL_TEXTURE_2D, breach_texture);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-                glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_TRUE);
-                glEnable(GL_BLEND);
-                glBlendFunc(GL_ZERO, GL_ONE);
-                glBlendEquation(GL_MIN);
-                glMatrixMode(GL_MODELVIEW);
-                glPushMatrix();
-                glMultMatrixf(it->getTransformation().values);
-                glBegin(GL_QUADS);
-                glTexCoord2f(0,0);
-                glVertex3f(-1, -1, 0);
-                glTexCoord2f(1,0);
-                glVertex3f( 1, -1, 0);
-                glTexCoord2f(1,1);
-                glVertex3f( 1,  1, 0);
-                glTexCoord2f(0,1);
-                glVertex3f(-1,  1, 0);
-                glEnd();
-                glPopMatrix();
-                glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-                glEnable(GL_LIGHTING);
-                // Draw wall, blending according to previous (destination) alpha
-                glClear(GL_DEPTH_BUFFER_BIT);
-                glBlendEquation(GL_FUNC_ADD);
-                glDisable(GL_TEXTURE_2D);
-                glDisable(GL_BLEND);
-            }
-        }
+    if (forSelection) {
+        FrustumCuller::render(*targetsRenderer, GL_SELECT);
+        FrustumCuller::render(*breachesRenderer, GL_SELECT);
+        return;
     }
-    // (Draw the wall even if there is no breach on it, or if we are in selection mode)
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_DST_ALPHA, GL_ONE_MINUS_DST_ALPHA);
-    wallsRenderer->fullRender(forSelection ? GL_SELECT : GL_RENDER);
-    glDisable(GL_BLEND);
-    if (!forSelection) {
-        // Make the framebuffer all opaque again // not sure it's useful
-        glColor4f(0,0,0,1);
-        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_TRUE);
-        glClear(GL_COLOR_BUFFER_BIT);
-        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+    // Draw lines from the wall to the targets
+    glColor4f(1.0, 1.0, 1.0, 1.0);
+    for (vector<Target>::iterator it = targets.begin() ; it < targets.end() ; it++) {
+        Target& t = *it;
+        float x = t.getX();
+        float y = t.getY();
+        float z = t.getZ();
+
+        glNormal3f(0, 0, 1);
+        glBegin(GL_LINES);
+        glVertex3f(x, y, -2);
+        glVertex3f(x, y, z);
+        glEnd();
     }
 
-    if (!forSelection) {
-        // Draw lines from the wall to the targets
-        glColor4f(1.0, 1.0, 1.0, 1.0);
-        for (vector<Target>::iterator it = targets.begin() ; it < targets.end() ; it++) {
-            Target& t = *it;
-            float x = t.getX();
-            float y = t.getY();
-            float z = t.getZ();
-
-            glNormal3f(0, 0, 1);
-            glBegin(GL_LINES);
-            glVertex3f(x, y, -2);
-            glVertex3f(x, y, z);
-            glEnd();
+    renderQueue.clear();
+    renderQueue.add(targetsRenderer, RenderState::OPAQUE_PASS);
+    renderQueue.submit();
+
+    // Show the scene seen through each breach, inside its hole
+    for (vector<Breach>::iterator it = breaches.begin() ; it < breaches.end() ; it++) {
+        if (BreachView::enter(*it)) {
+            placeLight();
+            draw_scene(false);
+            BreachView::leave();
+            placeLight();
         }
     }
 
-    targetsRenderer->fullRender(forSelection ? GL_SELECT : GL_RENDER);
-
-    breachesRenderer->fullRender(forSelection ? GL_SELECT : GL_RENDER);
-
+    // The breaches highlight themselves over the targets, and over the views through them
+    renderQueue.clear();
+    renderQueue.add(breachesRenderer, RenderState::BLENDED_PASS);
+    renderQueue.submit();
 }
 
 /**
@@ -246,34 +222,32 @@ void draw_scene(bool forSelection = false) {
 void doDisplay(bool forSelection = false) {
 
     // Compute the absolute look-at point
-    float playerLookAtReal[3];
-    for (int i = 0 ; i < 3 ; i++) playerLookAtReal[i] = playerPosition(i,0) + playerLookAt(i,0);
+    Matrix<float,4,1> playerLookAtReal = playerPosition + playerLookAt;
 
-    // Configure the view
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
-    gluLookAt(playerPosition(0,0), playerPosition(1,0), playerPosition(2,0), playerLookAtReal[0], playerLookAtReal[1], playerLookAtReal[2], playerInclinaison(0,0), playerInclinaison(1,0), playerInclinaison(2,0));
+    // Configure the view, keeping it on the CPU for the renderables to compose their transformations
+    // The projection is kept on the CPU too, where it is loaded (see reshape() and the selection)
+    TransformStack::loadView(MatrixHelper::lookAt(playerPosition, playerLookAtReal, playerInclinaison));
 
     if (!forSelection) {
         // Buffers reinitialisation
         glClearColor(0, 0, 0, 1);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+        BreachView::beginFrame();
 
         // General configuration
         glShadeModel(GL_SMOOTH);
         glHint(GL_PERSPECTIVE_CORRECTION_HINT, GL_NICEST);
-        glEnable(GL_DEPTH_TEST);
+        GLStateCache::enable(GL_DEPTH_TEST);
 
         // Configure a positionnal light
         GLfloat light_ambient[] = { 0, 0, 0, 1 };
         GLfloat light_diffuse[] = { 1, 1, 1, 1 };
         GLfloat light_specular[] = { 1, 1, 1, 1 };
-        //GLfloat light_position[] = { playerPosition[0], playerPosition[1], playerPosition[2], 1 }; // the player sheds its own light
-        GLfloat light_position[] = { 0, 0, 0, 1 };
         glLightfv(GL_LIGHT0, GL_AMBIENT, light_ambient);
         glLightfv(GL_LIGHT0, GL_DIFFUSE, light_diffuse);
         glLightfv(GL_LIGHT0, GL_SPECULAR, light_specular);
-        glLightfv(GL_LIGHT0, GL_POSITION, light_position);
+        placeLight();
+        TesseledRectangle::setLightPosition(Matrix<float,4,1>(lightPosition));
         glLightf(GL_LIGHT0, GL_CONSTANT_ATTENUATION, 1);
         glLightf(GL_LIGHT0, GL_LINEAR_ATTENUATION, .5);
         glLightf(GL_LIGHT0, GL_QUADRATIC_ATTENUATION, 1);
@@ -281,15 +255,37 @@ void doDisplay(bool forSelection = false) {
         GLfloat lmodel_ambient[] = { .1, .1, .1, 1 };
         glLightModelfv(GL_LIGHT_MODEL_AMBIENT, lmodel_ambient);
         glLightModeli(GL_LIGHT_MODEL_LOCAL_VIEWER, GL_TRUE);
-        //glLightModeli(GL_LIGHT_MODEL_TWO_SIDE, GL_TRUE);
+        // Double sided rectangles are drawn in a single pass, their back faces lit with the reversed normal
+        glLightModeli(GL_LIGHT_MODEL_TWO_SIDE, GL_TRUE);
 
-        glEnable(GL_LIGHTING);
-        glEnable(GL_LIGHT0);
+        GLStateCache::enable(GL_LIGHTING);
+        GLStateCache::enable(GL_LIGHT0);
     }
 
-    glEnable(GL_CULL_FACE);
+    GLStateCache::enable(GL_CULL_FACE);
 
     draw_scene(forSelection);
+
+    if (!forSelection)
+        BreachView::endFrame();
+}
+
+/**
+ * @brief Draws a line of text in the top right corner of the overlay.
+ *
+ * @param row    Line to draw, 0 being the topmost one
+ * @param format printf() like format of the text, followed by its arguments
+ */
+void drawOverlayLine(int row, const char* format, ...) {
+    char text[32];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    glRasterPos2d(windowWidth-60, windowHeight-20-16*row);
+    for (char* i = text; *i != '\0'; i++) {
+        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, *i);
+    }
 }
 
 /**
@@ -298,6 +294,9 @@ void doDisplay(bool forSelection = false) {
 void display() {
     static timeval lastcall = {0,0};
 
+    FrameBudget::beginFrame();
+    updatePlayerBasis();
+
     // Move player
     if (playerAdvance[0] != 0 || playerAdvance[1] != 0 || playerAdvance[2] != 0) {
         playerPosition = playerPosition + (playerLookAt*playerAdvance[0] - playerInclinaison*playerLookAt*playerAdvance[1] + playerInclinaison*playerAdvance[2]) * playerSpeed;
@@ -313,22 +312,25 @@ void display() {
     glPushMatrix();
     glLoadIdentity();
     gluOrtho2D(0, windowWidth, 0, windowHeight);
-    glDisable(GL_DEPTH_TEST);
-    glDisable(GL_LIGHTING);
+    GLStateCache::disable(GL_DEPTH_TEST);
+    GLStateCache::disable(GL_LIGHTING);
 
     // Crosshair
     crosshairRenderer->fullRender(GL_RENDER);
 
     // FPS
-    glEnable(GL_COLOR_LOGIC_OP);
+    GLStateCache::enable(GL_COLOR_LOGIC_OP);
     glLogicOp(GL_INVERT);
-    glRasterPos2d(windowWidth-60, windowHeight-20);
-    char fps_str[10];
-    sprintf(fps_str, "%d FPS", last_fps);
-    for (char* i = fps_str; *i != '\0'; i++) {
-        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, *i);
-    }
-    glDisable(GL_COLOR_LOGIC_OP);
+    drawOverlayLine(0, "%d FPS", last_fps);
+    // Redundant state changes elided during the last frame
+    drawOverlayLine(1, "%lu elided", GLStateCache::getElidedCalls());
+    // Renderables culled during the last frame
+    drawOverlayLine(2, "%lu culled", FrustumCuller::getCulledNodes());
+    // Views through the breaches skipped during the last frame
+    drawOverlayLine(3, "%lu skipped", BreachView::getSkippedViews());
+    // Depth the views through the breaches are cut at, to keep up with the frame rate
+    drawOverlayLine(4, "%u deep", MIN(BreachView::getDepthBudget(), BreachView::getMaxDepth()));
+    GLStateCache::disable(GL_COLOR_LOGIC_OP);
 
     // Restore matrices
     glMatrixMode(GL_PROJECTION);
@@ -336,8 +338,14 @@ void display() {
     glMatrixMode(GL_MODELVIEW);
     glPopMatrix();
 
+    // Measure the rendering alone, without the wait for the vertical synchronization in the swap
+    glFinish();
+    BreachView::setDepthBudget(FrameBudget::endFrame(BreachView::getDepthBudget(), BreachView::getMaxDepth()));
+
     //glFlush(); // for GLUT_SINGLE buffer
     glutSwapBuffers(); // for GLUT_DOUBLE buffer
+    GLStateCache::endFrame();
+    FrustumCuller::endFrame();
 
     // Attempt to respect a maximum frame rate
     timeval thiscall;
@@ -396,17 +404,21 @@ void doSelection(int button, int x, int y) {
 
     glMatrixMode(GL_PROJECTION);
     glPushMatrix();
-    glLoadIdentity();
-    // Zoom on the very pixel the mouse is onto
-    gluPickMatrix((GLdouble) x, (GLdouble) y, 1.0f, 1.0f, viewport);
-    gluPerspective(45.0f, (GLfloat) (viewport[2]-viewport[0])/(GLfloat) (viewport[3]-viewport[1]), 0.01f, 10.0f);
-
-    // Render the scene for selection
+    // Zoom on the very pixel the mouse is onto, culling against the picking region
+    Matrix<float,4,4> projection = TransformStack::getProjection();
+    Matrix<float,4,4> picking = MatrixHelper::pickMatrix<float>(x, y, 1, 1, viewport)
+                              * MatrixHelper::perspective<float>(45, (viewport[2]-viewport[0])/(double)(viewport[3]-viewport[1]), 0.01, 10);
+    glLoadMatrixf(picking.values);
+    TransformStack::setProjection(picking);
+
+    // Render the scene for selection, with the latest orientation
+    updatePlayerBasis();
     doDisplay(true);
 
     glMatrixMode(GL_PROJECTION);
     glPopMatrix();
     glMatrixMode(GL_MODELVIEW);
+    TransformStack::setProjection(projection);
 
     SelectionUtil selection = SelectionUtil::finishGlSelection(buffer);
     vector<SelectionUtil::Hit> hits = selection.getHits();
@@ -451,8 +463,10 @@ void doSelection(int button, int x, int y) {
         if (targetSelectionResolver.isSelectedObjectFound()) {
             Target* shotTarget = targetSelectionResolver.getSelectedObject();
             printf("Found : %p at (%f, %f, %f)\n", shotTarget, shotTarget->getX(), shotTarget->getY(), shotTarget->getZ());
-            if (button == 1)
+            if (button == 1) {
                 shotTarget->setHit();
+                BreachView::invalidate();
+            }
         } else {
             printf("No target hit\n");
 
@@ -463,7 +477,7 @@ void doSelection(int button, int x, int y) {
             if (wallSelectionResolver.isSelectedObjectFound()) {
                 Wall* shotWall = wallSelectionResolver.getSelectedObject();
                 printf("Found : %p\n", shotWall);
-                Matrix<float,4,1> obj = Matrix<float,4,1>((float[]){objX, objY, objZ, 1});
+                Matrix<float,4,1> obj = Matrix<float,4,1>(objX, objY, objZ, 1);
                 Matrix<float,4,1> corrected = shotWall->projectOnto(obj);
                 Matrix<float,2,1> wallC = shotWall->inWallCoordinates(obj);
                 printf("  shotPosition = (%f, %f, %f)\n", corrected[0], corrected[1], corrected[2]);
@@ -508,9 +522,9 @@ void mouse(int button, int state, int x, int y) {
         return;
     }
     if (state == GLUT_DOWN && (button == 3 || button == 4)) {
-        // Rotate inclinaison with mouse wheel
-        Matrix<float,4,4> rot = MatrixHelper::rotation(playerInclinaisonSpeed*(button == 4 ? 1 : -1), playerLookAt);
-        playerInclinaison = rot * playerInclinaison;
+        // Rotate inclinaison with mouse wheel, around the local look-at direction (-Z)
+        playerOrientation = playerOrientation * Quaternion<float>::fromAxisAngle(-playerInclinaisonSpeed*(button == 4 ? 1 : -1), MatrixHelper::unitAxisVector<float>(2));
+        playerOrientation.normalize();
     } else {
         if (button == GLUT_LEFT_BUTTON) {
             if (mouseButtonPressed[0] && state == GLUT_UP) {
@@ -562,10 +576,11 @@ void motion(int x, int y) {
     double angleY = (windowHeight/2-y) / 300.0 / 2.0;
     if (angleX == 0 && angleY == 0)
         return;
-    Matrix<float,4,4> rotX = MatrixHelper::rotation(angleX, playerInclinaison);
-    Matrix<float,4,4> rotY = MatrixHelper::rotation(angleY, playerLookAt*playerInclinaison);
-    playerLookAt = rotY * rotX * playerLookAt;
-    playerInclinaison = rotY * playerInclinaison;
+    // Turn around the local up (Y), then around the local right (X, as the player looks towards -Z)
+    playerOrientation = playerOrientation
+                      * Quaternion<float>::fromAxisAngle(angleY, MatrixHelper::unitAxisVector<float>(0))
+                      * Quaternion<float>::fromAxisAngle(angleX, MatrixHelper::unitAxisVector<float>(1));
+    playerOrientation.normalize();
     glutWarpPointer(windowWidth/2, windowHeight/2);
     glutPostRedisplay();
 }
@@ -594,6 +609,15 @@ void keyboard(unsigned char key, int x, int y) {
         playerAdvance[2] = MIN(1, playerAdvance[2]+1);
     } else if (key == 'e') {
         playerAdvance[2] = MAX(-1, playerAdvance[2]-1);
+    } else if (key == 'l') {
+        // Toggle per pixel lighting
+        PerPixelLighting::setEnabled(!PerPixelLighting::isEnabled());
+        BreachView::invalidate();
+    } else if (key == '+') {
+        // Look deeper through the breaches
+        BreachView::setMaxDepth(BreachView::getMaxDepth()+1);
+    } else if (key == '-') {
+        BreachView::setMaxDepth(BreachView::getMaxDepth() > 0 ? BreachView::getMaxDepth()-1 : 0);
     } else if (key == (char)27) { // Escape
         mouseCaptured = false;
         glutSetCursor(GLUT_CURSOR_INHERIT);
@@ -639,11 +663,13 @@ void reshape(int w, int h) {
     printf("%d x %d\n", w, h);
     // Reconfigure the viewport and perspective
     glViewport(0, 0, (GLsizei) windowWidth, (GLsizei) windowHeight);
+    TesseledRectangle::setViewportHeight(windowHeight);
     glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
     pixelToUnitScale = MIN(width/windowWidth, height/windowHeight);
-    // Preserve aspect pixel ratio of 1:1
-    gluPerspective(45.0, w/(GLdouble)h, 0.01, 10.0);
+    // Preserve aspect pixel ratio of 1:1, keeping the projection on the CPU for the culling
+    Matrix<float,4,4> projection = MatrixHelper::perspective<float>(45.0, w/(GLdouble)h, 0.01, 10.0);
+    glLoadMatrixf(projection.values);
+    TransformStack::setProjection(projection);
     glMatrixMode(GL_MODELVIEW);
     glLoadIdentity();
 }
@@ -669,7 +695,7 @@ int main(int argc, char** argv) {
     //glutInitContextProfile(GLUT_CORE_PROFILE);
 
     // Configure OpenGL and register callbacks
-    glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA | GLUT_DEPTH | GLUT_ALPHA);
+    glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA | GLUT_DEPTH | GLUT_ALPHA | GLUT_STENCIL);
     glutInitWindowSize(600, 600); // Size of the OpenGL window
     glutCreateWindow("Breach"); // Creates OpenGL Window
     glutDisplayFunc(display);
@@ -733,8 +759,15 @@ int main(int argc, char** argv) {
     initTargets(targetTexture);
     initWalls(wallTexture);
     initBreaches(breachTexture, breachHighlightTexture);
+    BreachView::init(breachTexture);
+    FrameBudget::setBudget(1.0/TARGET_FPS);
     crosshair.addBreach(breaches[0], 0);
     crosshair.addBreach(breaches[1], 2);
+    // Light the scene per pixel when possible, the fixed function pipeline being the fallback
+    PerPixelLighting::init();
+    wallsRenderer = new PerPixelLightingCompositeRenderable(wallsRenderer);
+    targetsRenderer = new PerPixelLightingCompositeRenderable(targetsRenderer);
+    breachesRenderer = new PerPixelLightingCompositeRenderable(breachesRenderer);
 
     // Let OpenGL control the program through its main loop
     glutMainLoop();
@@ -14,9 +14,16 @@
  * http://www.opensource.org/licenses/BSD-2-Clause
  */
 
+#define GL_GLEXT_PROTOTYPES 1
+
 #include "renderable.hpp"
+#include "vectors.hpp"
+#include "glstate.hpp"
+#include "lighting.hpp"
 
 #include <cfloat>
+#include <cmath>
+#include <algorithm>
 
 using namespace std;
 
@@ -47,6 +54,11 @@ void IRenderable::deconfigure(GLenum renderingMode)
 {
 }
 
+BoundingVolume IRenderable::getBounds()
+{
+    return BoundingVolume::everything();
+}
+
 
 
 SelectableRenderable::SelectableRenderable(GLuint name, Any payload)
@@ -105,8 +117,18 @@ void CompositeRenderable::render(GLenum renderingMode)
 {
     for (vector<IRenderable*>::iterator it = components.begin() ; it < components.end() ; it++) {
         IRenderable* target = *it;
-        target->fullRender(renderingMode);
+        FrustumCuller::render(*target, renderingMode);
+    }
+}
+
+BoundingVolume CompositeRenderable::getBounds()
+{
+    BoundingVolume rtn;
+    for (vector<IRenderable*>::iterator it = components.begin() ; it < components.end() ; it++) {
+        rtn.merge((*it)->getBounds());
+        if (rtn.isInfinite()) break;
     }
+    return rtn;
 }
 
 bool CompositeRenderable::accept(HierarchicalVisitor<IRenderable>& visitor)
@@ -160,21 +182,192 @@ TransformerRenderable::~TransformerRenderable()
 
 
 
-MatrixTransformerRenderable::MatrixTransformerRenderable(Matrix<float,4,4> transformation, MatrixMode matrixMode)
-: matrixMode(matrixMode)
-, transformation(transformation)
+QueueableRenderable::QueueableRenderable()
+{
+}
+
+QueueableRenderable::~QueueableRenderable()
+{
+}
+
+bool QueueableRenderable::isFlattened()
+{
+    return true;
+}
+
+
+
+ViewDependentRenderable::ViewDependentRenderable()
+{
+}
+
+ViewDependentRenderable::~ViewDependentRenderable()
+{
+}
+
+
+
+Matrix<float,4,4> TransformStack::view (MatrixHelper::identity<float>());
+Matrix<float,4,4> TransformStack::projection (MatrixHelper::identity<float>());
+std::vector<TransformStack::Level> TransformStack::levels (1, TransformStack::Level{ MatrixHelper::identity<float>(), MatrixHelper::identity<float>(), 0, Frustum(), false });
+unsigned long TransformStack::lastVersion = 0;
+bool TransformStack::recording = false;
+
+void TransformStack::loadView(const Matrix<float,4,4>& view)
+{
+    assert(levels.size() == 1);
+    TransformStack::view = view;
+    levels[0].modelView = view;
+    levels[0].frustumKnown = false;
+    glMatrixMode(GL_MODELVIEW);
+    glLoadMatrixf(view.values);
+}
+
+const Matrix<float,4,4>& TransformStack::getView()
+{
+    return view;
+}
+
+const Matrix<float,4,4>& TransformStack::getProjection()
+{
+    return projection;
+}
+
+void TransformStack::setProjection(const Matrix<float,4,4>& projection)
+{
+    TransformStack::projection = projection;
+    for (vector<Level>::iterator it = levels.begin() ; it < levels.end() ; it++)
+        it->frustumKnown = false;
+}
+
+const Frustum& TransformStack::getFrustum()
+{
+    Level& level = levels.back();
+    if (!level.frustumKnown) {
+        Matrix<float,4,4> clip = projection * level.modelView;
+        level.frustum = Frustum(clip);
+        level.frustumKnown = true;
+    }
+    return level.frustum;
+}
+
+const Matrix<float,4,4>& TransformStack::getWorld()
+{
+    return levels.back().world;
+}
+
+unsigned long TransformStack::getWorldVersion()
+{
+    return levels.back().version;
+}
+
+unsigned long TransformStack::newVersion()
+{
+    return ++lastVersion;
+}
+
+void TransformStack::push(const Matrix<float,4,4>& world, unsigned long version, const Matrix<float,4,4>& local)
+{
+    Level level = { world, view * world, version, Frustum(), false };
+    levels.push_back(level);
+    if (recording) {
+        glPushMatrix();
+        glMultMatrixf(local.values);
+    } else {
+        glLoadMatrixf(levels.back().modelView.values);
+    }
+}
+
+void TransformStack::pop()
+{
+    assert(levels.size() > 1);
+    levels.pop_back();
+    if (recording) {
+        glPopMatrix();
+    } else {
+        glLoadMatrixf(levels.back().modelView.values);
+    }
+}
+
+bool TransformStack::isRecording()
+{
+    return recording;
+}
+
+void TransformStack::setRecording(bool recording)
+{
+    TransformStack::recording = recording;
+}
+
+
+
+bool FrustumCuller::enabled = true;
+bool FrustumCuller::inside = false;
+unsigned long FrustumCuller::culledNodes = 0;
+unsigned long FrustumCuller::lastFrameCulledNodes = 0;
+
+bool FrustumCuller::isEnabled()
+{
+    return enabled;
+}
+
+void FrustumCuller::setEnabled(bool enabled)
+{
+    FrustumCuller::enabled = enabled;
+}
+
+bool FrustumCuller::isCulled(IRenderable& renderable, bool& inside)
+{
+    if (!enabled || inside || TransformStack::isRecording()) return false;
+    switch (TransformStack::getFrustum().classify(renderable.getBounds())) {
+        case Frustum::OUTSIDE:
+            culledNodes++;
+            return true;
+        case Frustum::INSIDE:
+            inside = true;
+            break;
+        case Frustum::INTERSECTING:
+            break;
+    }
+    return false;
+}
+
+void FrustumCuller::render(IRenderable& renderable, GLenum renderingMode)
+{
+    bool parentInside = inside;
+    if (isCulled(renderable, inside)) return;
+    renderable.fullRender(renderingMode);
+    inside = parentInside;
+}
+
+void FrustumCuller::endFrame()
 {
+    lastFrameCulledNodes = culledNodes;
+    culledNodes = 0;
 }
 
-MatrixTransformerRenderable::MatrixTransformerRenderable(Matrix<float,4,4>& transformation, MatrixMode matrixMode)
+unsigned long FrustumCuller::getCulledNodes()
+{
+    return lastFrameCulledNodes;
+}
+
+
+
+MatrixTransformerRenderable::MatrixTransformerRenderable(const Matrix<float,4,4>& transformation, MatrixMode matrixMode)
 : matrixMode(matrixMode)
 , transformation(transformation)
+, worldVersion(0)
+, parentWorldVersion(0)
+, worldDirty(true)
 {
 }
 
 MatrixTransformerRenderable::MatrixTransformerRenderable(Matrix<float,4,1> offset, Matrix<float,4,1> axisX, Matrix<float,4,1> axisY, MatrixMode matrixMode)
 : matrixMode(matrixMode)
 , transformation(computeTransformationMatrix(offset,axisX,axisY))
+, worldVersion(0)
+, parentWorldVersion(0)
+, worldDirty(true)
 {
 }
 
@@ -184,9 +377,8 @@ MatrixTransformerRenderable::~MatrixTransformerRenderable()
 
 Matrix<float,4,4> MatrixTransformerRenderable::computeTransformationMatrix(Matrix<float,4,1> offset, Matrix<float,4,1> axisX, Matrix<float,4,1> axisY)
 {
-    Matrix<float,4,1> axisZ = axisX * axisY;
-    axisZ = axisZ / axisZ.norm(); // important for the normals
-    return Matrix<float,4,4>((float[]){axisX[0],axisX[1],axisX[2],0, axisY[0],axisY[1],axisY[2],0, axisZ[0],axisZ[1],axisZ[2],0, offset[0], offset[1], offset[2], 1});
+    Vec3f axisZ = normalize(cross(Vec3f(axisX), Vec3f(axisY))); // important for the normals
+    return Matrix<float,4,4>(axisX[0],axisX[1],axisX[2],0, axisY[0],axisY[1],axisY[2],0, axisZ.x(),axisZ.y(),axisZ.z(),0, offset[0], offset[1], offset[2], 1);
 }
 
 MatrixTransformerRenderable::MatrixMode MatrixTransformerRenderable::getMatrixMode()
@@ -199,17 +391,129 @@ Matrix<float,4,4> MatrixTransformerRenderable::getTransformation()
     return transformation;
 }
 
+void MatrixTransformerRenderable::setTransformation(const Matrix<float,4,4>& transformation)
+{
+    if (memcmp(this->transformation.values, transformation.values, sizeof(transformation.values)) == 0) return;
+    this->transformation = transformation;
+    worldDirty = true;
+}
+
+Matrix<float,4,4> MatrixTransformerRenderable::getInverseTransformation()
+{
+    return MatrixHelper::affineInverse(transformation);
+}
+
+const Matrix<float,4,4>& MatrixTransformerRenderable::getWorldTransformation() const
+{
+    return worldTransformation;
+}
+
 void MatrixTransformerRenderable::loadTransform(GLenum renderingMode)
 {
-    glMatrixMode(matrixMode);
-    glPushMatrix();
-    glMultMatrixf(transformation.values);
+    if (matrixMode != MODELVIEW) {
+        glMatrixMode(matrixMode);
+        glPushMatrix();
+        glMultMatrixf(transformation.values);
+        glMatrixMode(GL_MODELVIEW);
+        return;
+    }
+    // Compose on the CPU, only if this transformation or any of the parent ones changed
+    if (worldDirty || parentWorldVersion != TransformStack::getWorldVersion()) {
+        worldTransformation = TransformStack::getWorld() * transformation;
+        parentWorldVersion = TransformStack::getWorldVersion();
+        worldVersion = TransformStack::newVersion();
+        worldDirty = false;
+    }
+    TransformStack::push(worldTransformation, worldVersion, transformation);
 }
 
 void MatrixTransformerRenderable::unloadTransform(GLenum renderingMode)
 {
-    glMatrixMode(matrixMode);
-    glPopMatrix();
+    if (matrixMode != MODELVIEW) {
+        glMatrixMode(matrixMode);
+        glPopMatrix();
+        glMatrixMode(GL_MODELVIEW);
+        return;
+    }
+    TransformStack::pop();
+}
+
+
+
+std::vector< std::pair<ViewDependentRenderable*,unsigned int> >* CompiledRenderable::recordingViewDependents = NULL;
+unsigned int CompiledRenderable::view = 0;
+
+CompiledRenderable::List::List()
+: name(0)
+, dirty(true)
+, parentWorldVersion(0)
+, viewDependents()
+{
+}
+
+CompiledRenderable::CompiledRenderable(IRenderable* subtree)
+: CompositeRenderable()
+, lists()
+{
+    components.push_back(subtree);
+}
+
+CompiledRenderable::~CompiledRenderable()
+{
+    for (map<pair<unsigned int,unsigned int>,List>::iterator it = lists.begin() ; it != lists.end() ; it++)
+        if (it->second.name != 0) glDeleteLists(it->second.name, 1);
+}
+
+void CompiledRenderable::markDirty()
+{
+    for (map<pair<unsigned int,unsigned int>,List>::iterator it = lists.begin() ; it != lists.end() ; it++)
+        it->second.dirty = true;
+}
+
+void CompiledRenderable::dependOnView(ViewDependentRenderable* renderable, unsigned int variant)
+{
+    if (recordingViewDependents != NULL)
+        recordingViewDependents->push_back(make_pair(renderable, variant));
+}
+
+void CompiledRenderable::setView(unsigned int view)
+{
+    CompiledRenderable::view = view;
+}
+
+bool CompiledRenderable::isOutdated(const List& list)
+{
+    for (vector< pair<ViewDependentRenderable*,unsigned int> >::const_iterator it = list.viewDependents.begin() ; it < list.viewDependents.end() ; it++)
+        if (it->first->getViewVariant() != it->second) return true;
+    return false;
+}
+
+void CompiledRenderable::render(GLenum renderingMode)
+{
+    unsigned int mode = renderingMode - GL_RENDER; // GL_RENDER, GL_FEEDBACK and GL_SELECT are consecutive
+    if (mode >= MODES || TransformStack::isRecording()) {
+        CompositeRenderable::render(renderingMode);
+        return;
+    }
+    List& list = lists[make_pair(view, mode)];
+    if (list.dirty || list.parentWorldVersion != TransformStack::getWorldVersion() || isOutdated(list)) {
+        if (list.name == 0) list.name = glGenLists(1);
+        glNewList(list.name, GL_COMPILE);
+        TransformStack::setRecording(true);
+        GLStateCache::setRecording(true);
+        list.viewDependents.clear();
+        recordingViewDependents = &list.viewDependents;
+        CompositeRenderable::render(renderingMode);
+        recordingViewDependents = NULL;
+        GLStateCache::setRecording(false);
+        TransformStack::setRecording(false);
+        glEndList();
+        list.dirty = false;
+        list.parentWorldVersion = TransformStack::getWorldVersion();
+    }
+    glCallList(list.name);
+    // The state changes of the list happened behind the cache
+    GLStateCache::invalidate();
 }
 
 
@@ -232,10 +536,10 @@ Texture::Texture(GLuint name, GLint internalFormat, GLsizei width, GLsizei heigh
 , wrapS(REPEAT)
 , wrapT(REPEAT)
 {
-    glBindTexture(GL_TEXTURE_2D, name);
+    GLStateCache::bindTexture(GL_TEXTURE_2D, name);
     glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, static_cast<const GLvoid*>(pixels));
     // Unbind the texture
-    glBindTexture(GL_TEXTURE_2D, Texture::NO_TEXTURE.getName());
+    GLStateCache::bindTexture(GL_TEXTURE_2D, Texture::NO_TEXTURE.getName());
 }
 
 GLuint Texture::getName() const
@@ -285,6 +589,29 @@ void Texture::setWrapT(Wrap value)
 
 
 
+void Material::apply() const
+{
+    GLStateCache::materialfv(GL_FRONT_AND_BACK, GL_AMBIENT, ambient);
+    GLStateCache::materialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, diffuse);
+    GLStateCache::materialfv(GL_FRONT_AND_BACK, GL_SPECULAR, specular);
+    GLStateCache::materialf(GL_FRONT_AND_BACK, GL_SHININESS, shininess);
+}
+
+
+
+RenderState::RenderState()
+: pass(OPAQUE_PASS)
+, blend(NO_BLEND)
+, alphaThreshold(-1)
+, writeAlpha(true)
+, texture(Texture::NO_TEXTURE)
+, material(NULL)
+, perPixelLighting(false)
+{
+}
+
+
+
 Texturer::Texturer(const Texture& texture)
 : texture(texture)
 {
@@ -303,31 +630,49 @@ void Texturer::configure(GLenum renderingMode)
 {
     if (renderingMode == GL_SELECT) return;
     if (texture.getName() != Texture::NO_TEXTURE.getName()) {
-        glEnable(GL_TEXTURE_2D);
-        glBindTexture(GL_TEXTURE_2D, texture.getName());
+        GLStateCache::enable(GL_TEXTURE_2D);
+        GLStateCache::bindTexture(GL_TEXTURE_2D, texture.getName());
     }
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, texture.getMinFilter());
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, texture.getMagFilter());
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, texture.getWrapS());
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, texture.getWrapT());
+    GLStateCache::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, texture.getMinFilter());
+    GLStateCache::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, texture.getMagFilter());
+    GLStateCache::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, texture.getWrapS());
+    GLStateCache::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, texture.getWrapT());
 }
 
 void Texturer::deconfigure(GLenum renderingMode)
 {
     if (renderingMode == GL_SELECT) return;
-    glBindTexture(GL_TEXTURE_2D, Texture::NO_TEXTURE.getName());
-    glDisable(GL_TEXTURE_2D);
+    GLStateCache::bindTexture(GL_TEXTURE_2D, Texture::NO_TEXTURE.getName());
+    GLStateCache::disable(GL_TEXTURE_2D);
+}
+
+
+bool TexturerCompositeRenderable::describeState(RenderState& state)
+{
+    state.texture = getTexture();
+    return true;
 }
 
 
 
+const float TesseledRectangle::PIXELS_PER_STEP = 24;
+const float TesseledRectangle::LIGHT_DISTANCE_PER_STEP = .1f;
+Matrix<float,4,1> TesseledRectangle::lightPosition (0, 0, 0, 1);
+float TesseledRectangle::viewportHeight = 600;
+
 TesseledRectangle::TesseledRectangle(unsigned int xSteps, unsigned int ySteps, const Rect textureOffsetAndSize, bool doubleSided)
 : MatrixTransformerRenderable(MatrixHelper::identity<float>())
 , doubleSided(doubleSided)
 , xSteps(xSteps)
 , ySteps(ySteps)
 , textureOffsetAndSize(textureOffsetAndSize)
+, level(0)
 {
+    for (unsigned int i = 0 ; i < LEVELS ; i++) {
+        meshes[i].vertexBuffer = 0;
+        meshes[i].indexBuffer = 0;
+        meshes[i].indexCount = 0;
+    }
 }
 
 TesseledRectangle::TesseledRectangle(Matrix<float,4,1> offset, Matrix<float,4,1> axisX, Matrix<float,4,1> axisY, unsigned int xSteps, unsigned int ySteps, const Rect textureOffsetAndSize, bool doubleSided)
@@ -336,63 +681,208 @@ TesseledRectangle::TesseledRectangle(Matrix<float,4,1> offset, Matrix<float,4,1>
 , xSteps(xSteps)
 , ySteps(ySteps)
 , textureOffsetAndSize(textureOffsetAndSize)
+, level(0)
 {
+    for (unsigned int i = 0 ; i < LEVELS ; i++) {
+        meshes[i].vertexBuffer = 0;
+        meshes[i].indexBuffer = 0;
+        meshes[i].indexCount = 0;
+    }
 }
 
 TesseledRectangle::~TesseledRectangle()
 {
+    for (unsigned int i = 0 ; i < LEVELS ; i++) {
+        if (meshes[i].vertexBuffer != 0) glDeleteBuffers(1, &meshes[i].vertexBuffer);
+        if (meshes[i].indexBuffer != 0) glDeleteBuffers(1, &meshes[i].indexBuffer);
+    }
+}
+
+void TesseledRectangle::setLightPosition(const Matrix<float,4,1>& position)
+{
+    lightPosition = position;
+}
+
+void TesseledRectangle::setViewportHeight(float height)
+{
+    viewportHeight = height;
+}
+
+unsigned int TesseledRectangle::getSteps(unsigned int steps, unsigned int level)
+{
+    if (level == LEVELS-1) return 1;
+    // Halve, rounding up, and keep at least one step
+    steps = (steps + (1 << level) - 1) >> level;
+    return steps > 0 ? steps : 1;
+}
+
+/**
+ * @brief Returns the distance between a point and the rectangle spanned by two axes, in eye coordinates.
+ *
+ * The closest point is searched along each axis independently, which is exact for orthogonal axes.
+ *
+ * @param point  The point
+ * @param origin Origin of the rectangle
+ * @param axisX  X axis of the rectangle
+ * @param axisY  Y axis of the rectangle
+ */
+static float distanceToRectangle(const Matrix<float,4,1>& point, const Matrix<float,4,1>& origin, const Matrix<float,4,1>& axisX, const Matrix<float,4,1>& axisY)
+{
+    float relative[3], u = 0, v = 0, xx = 0, yy = 0;
+    for (unsigned int i = 0 ; i < 3 ; i++) {
+        relative[i] = point[i] - origin[i];
+        u += relative[i] * axisX[i];
+        v += relative[i] * axisY[i];
+        xx += axisX[i] * axisX[i];
+        yy += axisY[i] * axisY[i];
+    }
+    u = xx > 0 ? max(0.f, min(1.f, u / xx)) : 0;
+    v = yy > 0 ? max(0.f, min(1.f, v / yy)) : 0;
+    float distance = 0;
+    for (unsigned int i = 0 ; i < 3 ; i++) {
+        float d = relative[i] - u * axisX[i] - v * axisY[i];
+        distance += d * d;
+    }
+    return sqrt(distance);
+}
+
+unsigned int TesseledRectangle::selectLevel()
+{
+    if (PerPixelLighting::isBound()) return LEVELS-1;
+    if (matrixMode != MODELVIEW) return 0;
+    Matrix<float,4,4> modelView = TransformStack::getView() * getWorldTransformation();
+    Matrix<float,4,1> origin, axisX, axisY, eye (0, 0, 0, 1);
+    for (unsigned int l = 0 ; l < 4 ; l++) {
+        axisX[l] = modelView(l,0);
+        axisY[l] = modelView(l,1);
+        origin[l] = modelView(l,3);
+    }
+    Matrix<float,4,1> light = TransformStack::getView() * lightPosition;
+    float lengthX = axisX.norm();
+    float lengthY = axisY.norm();
+
+    // Steps needed for the on screen length of each axis, as seen at the closest point
+    float pixelsPerUnit = TransformStack::getProjection()(1,1) * viewportHeight / 2 / max(distanceToRectangle(eye, origin, axisX, axisY), .01f);
+    float neededX = lengthX * pixelsPerUnit / PIXELS_PER_STEP;
+    float neededY = lengthY * pixelsPerUnit / PIXELS_PER_STEP;
+    // Steps needed for the lighting, which varies faster near the light
+    float stepLength = LIGHT_DISTANCE_PER_STEP * max(distanceToRectangle(light, origin, axisX, axisY), .01f);
+    neededX = min(neededX, lengthX / stepLength);
+    neededY = min(neededY, lengthY / stepLength);
+
+    for (unsigned int rtn = LEVELS-1 ; rtn > 0 ; rtn--)
+        if (getSteps(xSteps, rtn) >= neededX && getSteps(ySteps, rtn) >= neededY)
+            return rtn;
+    return 0;
+}
+
+unsigned int TesseledRectangle::getViewVariant()
+{
+    return selectLevel();
+}
+
+void TesseledRectangle::buildBuffers(unsigned int level)
+{
+    unsigned int xSteps = getSteps(this->xSteps, level);
+    unsigned int ySteps = getSteps(this->ySteps, level);
+    Mesh& mesh = meshes[level];
+    // Grid of (xSteps+1)*(ySteps+1) vertices, shared by the adjacent quads, each being X, Y, Z, S, T
+    vector<GLfloat> vertices;
+    vertices.reserve((xSteps+1) * (ySteps+1) * 5);
+    for (unsigned int y = 0 ; y <= ySteps ; y++) {
+        for (unsigned int x = 0 ; x <= xSteps ; x++) {
+            vertices.push_back(x / (float)xSteps);
+            vertices.push_back(y / (float)ySteps);
+            vertices.push_back(0);
+            vertices.push_back(textureOffsetAndSize.x + textureOffsetAndSize.width  * x / (float)xSteps);
+            vertices.push_back(textureOffsetAndSize.y + textureOffsetAndSize.height * y / (float)ySteps);
+        }
+    }
+    // Two counter-clockwise triangles per quad
+    vector<GLuint> indices;
+    indices.reserve(xSteps * ySteps * 6);
+    for (unsigned int y = 0 ; y < ySteps ; y++) {
+        for (unsigned int x = 0 ; x < xSteps ; x++) {
+            GLuint bottomLeft = y * (xSteps+1) + x;
+            GLuint topLeft = bottomLeft + xSteps+1;
+            indices.push_back(bottomLeft);
+            indices.push_back(bottomLeft+1);
+            indices.push_back(topLeft+1);
+            indices.push_back(bottomLeft);
+            indices.push_back(topLeft+1);
+            indices.push_back(topLeft);
+        }
+    }
+    mesh.indexCount = indices.size();
+
+    glGenBuffers(1, &mesh.vertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), &vertices[0], GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glGenBuffers(1, &mesh.indexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), &indices[0], GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
 void TesseledRectangle::render(GLenum renderingMode)
 {
-    doRender(renderingMode, false);
-    if (doubleSided) {
-        glCullFace(GL_FRONT);
-        doRender(renderingMode, true);
-        glCullFace(GL_BACK);
+    if (renderingMode == GL_RENDER) {
+        level = selectLevel();
+        CompiledRenderable::dependOnView(this, level);
+        if (meshes[level].vertexBuffer == 0) buildBuffers(level);
+        glBindBuffer(GL_ARRAY_BUFFER, meshes[level].vertexBuffer);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, meshes[level].indexBuffer);
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glVertexPointer(3, GL_FLOAT, 5 * sizeof(GLfloat), reinterpret_cast<const GLvoid*>(0));
+        glTexCoordPointer(2, GL_FLOAT, 5 * sizeof(GLfloat), reinterpret_cast<const GLvoid*>(3 * sizeof(GLfloat)));
+    }
+    // Both sides at once if double sided, the back one being lit with the reversed normal by two sided lighting
+    if (doubleSided)
+        GLStateCache::disable(GL_CULL_FACE);
+    doRender(renderingMode);
+    if (doubleSided)
+        GLStateCache::enable(GL_CULL_FACE);
+    if (renderingMode == GL_RENDER) {
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+}
+
+BoundingVolume TesseledRectangle::getBounds()
+{
+    BoundingVolume rtn (Matrix<float,4,1>(0, 0, 0, 1), Matrix<float,4,1>(1, 1, 0, 1));
+    switch (matrixMode) {
+        case MODELVIEW:
+            return rtn.transform(transformation);
+        case TEXTURE:
+        case COLOR:
+            return rtn;
+        default:
+            return BoundingVolume::everything();
     }
 }
 
-void TesseledRectangle::doRender(GLenum renderingMode, bool reverseNormal)
+void TesseledRectangle::doRender(GLenum renderingMode)
 {
-    glNormal3f(0,0,reverseNormal ? -1 : 1);
-    glBegin(GL_QUADS);
+    glNormal3f(0,0,1);
     switch (renderingMode) {
-        case GL_RENDER:{
-            float dx = 1.0f / xSteps;
-            float dy = 1.0f / ySteps;
-            float dtx = textureOffsetAndSize.width  / (float)xSteps;
-            float dty = textureOffsetAndSize.height / (float)ySteps;
-            float _x = 0;
-            float _y = 0;
-            float _tx = textureOffsetAndSize.x;
-            float _ty = textureOffsetAndSize.y;
-            for (unsigned int s1 = 0 ; s1 < ySteps ; s1++, _y += dy, _ty += dty) {
-                float __x = 0;
-                float __y = 0;
-                float __tx = 0;
-                float __ty = 0;
-                for (unsigned int s2 = 0 ; s2 < xSteps ; s2++, __x += dx, __tx += dtx) {
-                    glTexCoord2f(textureOffsetAndSize.x + _tx+__tx    , textureOffsetAndSize.y + _ty+__ty    );
-                    glVertex3f(_x+__x   , _y+__y   , 0);
-                    glTexCoord2f(textureOffsetAndSize.x + _tx+__tx+dtx, textureOffsetAndSize.y + _ty+__ty    );
-                    glVertex3f(_x+__x+dx, _y+__y   , 0);
-                    glTexCoord2f(textureOffsetAndSize.x + _tx+__tx+dtx, textureOffsetAndSize.y + _ty+__ty+dty);
-                    glVertex3f(_x+__x+dx, _y+__y+dy, 0);
-                    glTexCoord2f(textureOffsetAndSize.x + _tx+__tx    , textureOffsetAndSize.y + _ty+__ty+dty);
-                    glVertex3f(_x+__x   , _y+__y+dy, 0);
-                }
-            }
-            break;}
+        case GL_RENDER:
+            glDrawElements(GL_TRIANGLES, meshes[level].indexCount, GL_UNSIGNED_INT, reinterpret_cast<const GLvoid*>(0));
+            break;
         case GL_FEEDBACK:
         case GL_SELECT:
+            glBegin(GL_QUADS);
             glVertex3f(0,0,0);
             glVertex3f(1,0,0);
             glVertex3f(1,1,0);
             glVertex3f(0,1,0);
+            glEnd();
             break;
     }
-    glEnd();
 }
 
 
@@ -433,3 +923,17 @@ void RegularPolygon::render(GLenum renderingMode)
     glVertex3d(1, 0, 0);
     glEnd();
 }
+
+BoundingVolume RegularPolygon::getBounds()
+{
+    BoundingVolume rtn (Matrix<float,4,1>(-1, -1, 0, 1), Matrix<float,4,1>(1, 1, 0, 1));
+    switch (matrixMode) {
+        case MODELVIEW:
+            return rtn.transform(transformation);
+        case TEXTURE:
+        case COLOR:
+            return rtn;
+        default:
+            return BoundingVolume::everything();
+    }
+}
@@ -0,0 +1,179 @@
+/**
+ * @file renderqueue.cpp
+ *
+ * @brief Sorted queue of draw items, flattened from renderables.
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2011 Olivier Favre
+ *
+ * This file is part of Breach.
+ *
+ * Licensed under the Simplified BSD License,
+ * for details please see LICENSE file or the website
+ * http://www.opensource.org/licenses/BSD-2-Clause
+ */
+
+#include <algorithm>
+
+#include "renderqueue.hpp"
+#include "glstate.hpp"
+#include "lighting.hpp"
+
+using namespace std;
+
+
+
+bool RenderQueue::Item::operator<(const Item& other) const
+{
+    return key < other.key;
+}
+
+RenderQueue::RenderQueue()
+: items()
+, materials()
+{
+}
+
+RenderQueue::~RenderQueue()
+{
+}
+
+void RenderQueue::clear()
+{
+    items.clear();
+    materials.clear();
+}
+
+void RenderQueue::add(IRenderable* root, RenderState::Pass pass)
+{
+    RenderState state;
+    state.pass = pass;
+    flatten(root, state, false);
+}
+
+unsigned int RenderQueue::size() const
+{
+    return items.size();
+}
+
+void RenderQueue::flatten(IRenderable* renderable, RenderState state, bool inside)
+{
+    if (FrustumCuller::isCulled(*renderable, inside))
+        return;
+    QueueableRenderable* queueable = dynamic_cast<QueueableRenderable*>(renderable);
+    CompositeRenderable* composite = dynamic_cast<CompositeRenderable*>(renderable);
+    if (queueable == NULL || (composite != NULL && dynamic_cast<TransformerRenderable*>(renderable) != NULL)) {
+        push(renderable, state, true);
+        return;
+    }
+    if (!queueable->describeState(state))
+        return;
+    if (composite == NULL || !queueable->isFlattened()) {
+        push(renderable, state, false);
+        return;
+    }
+    for (vector<IRenderable*>::iterator it = composite->components.begin() ; it < composite->components.end() ; it++) {
+        flatten(*it, state, inside);
+    }
+}
+
+void RenderQueue::push(IRenderable* renderable, const RenderState& state, bool fallback)
+{
+    Item item = { computeKey(state), renderable, fallback, state };
+    items.push_back(item);
+}
+
+uint64_t RenderQueue::computeKey(const RenderState& state)
+{
+    uint64_t material = 0;
+    if (state.material != NULL) {
+        vector<const Material*>::iterator it = find(materials.begin(), materials.end(), state.material);
+        if (it == materials.end())
+            it = materials.insert(it, state.material);
+        material = it - materials.begin() + 1;
+    }
+    return (uint64_t)(state.pass & 0xF) << 60
+         | (uint64_t)(state.blend & 0x3) << 58
+         | (uint64_t)(state.alphaThreshold >= 0) << 57
+         | (uint64_t)(!state.writeAlpha) << 56
+         | (uint64_t)(state.perPixelLighting) << 55
+         | (uint64_t)(state.texture.getName() & 0x7FFF) << 40
+         | (material & 0xFFFF) << 24
+         | (items.size() & 0xFFFFFF);
+}
+
+void RenderQueue::apply(const RenderState* current, const RenderState& state)
+{
+    if (current == NULL || current->blend != state.blend) {
+        switch (state.blend) {
+            case RenderState::NO_BLEND:
+                GLStateCache::disable(GL_BLEND);
+                break;
+            case RenderState::ALPHA_BLEND:
+                GLStateCache::enable(GL_BLEND);
+                GLStateCache::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+                break;
+            case RenderState::DESTINATION_ALPHA_BLEND:
+                GLStateCache::enable(GL_BLEND);
+                GLStateCache::blendFunc(GL_DST_ALPHA, GL_ONE_MINUS_DST_ALPHA);
+                break;
+        }
+    }
+    if (current == NULL || current->alphaThreshold != state.alphaThreshold) {
+        if (state.alphaThreshold >= 0) {
+            GLStateCache::enable(GL_ALPHA_TEST);
+            glAlphaFunc(GL_GREATER, state.alphaThreshold);
+        } else
+            GLStateCache::disable(GL_ALPHA_TEST);
+    }
+    if (current == NULL || current->writeAlpha != state.writeAlpha) {
+        GLStateCache::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, state.writeAlpha ? GL_TRUE : GL_FALSE);
+    }
+    const Texture& texture = state.texture;
+    if (current == NULL || current->texture.getName() != texture.getName()
+            || current->texture.getMinFilter() != texture.getMinFilter() || current->texture.getMagFilter() != texture.getMagFilter()
+            || current->texture.getWrapS() != texture.getWrapS() || current->texture.getWrapT() != texture.getWrapT()) {
+        // Same as a Texturer configuring, then deconfiguring
+        if (texture.getName() != Texture::NO_TEXTURE.getName()) {
+            GLStateCache::enable(GL_TEXTURE_2D);
+            GLStateCache::bindTexture(GL_TEXTURE_2D, texture.getName());
+            GLStateCache::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, texture.getMinFilter());
+            GLStateCache::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, texture.getMagFilter());
+            GLStateCache::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, texture.getWrapS());
+            GLStateCache::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, texture.getWrapT());
+        } else {
+            GLStateCache::bindTexture(GL_TEXTURE_2D, Texture::NO_TEXTURE.getName());
+            GLStateCache::disable(GL_TEXTURE_2D);
+        }
+    }
+    if (current == NULL || current->perPixelLighting != state.perPixelLighting) {
+        if (state.perPixelLighting)
+            PerPixelLighting::bind();
+        else
+            PerPixelLighting::unbind();
+    }
+    if (state.material != NULL && (current == NULL || current->material != state.material)) {
+        state.material->apply();
+    }
+}
+
+void RenderQueue::submit()
+{
+    sort(items.begin(), items.end());
+    const RenderState* current = NULL;
+    for (vector<Item>::iterator it = items.begin() ; it < items.end() ; it++) {
+        apply(current, it->state);
+        current = &it->state;
+        if (it->fallback) {
+            it->renderable->fullRender(GL_RENDER);
+            // The state may have been changed behind the queue
+            current = NULL;
+        } else {
+            it->renderable->loadTransform(GL_RENDER);
+            it->renderable->render(GL_RENDER);
+            it->renderable->unloadTransform(GL_RENDER);
+        }
+    }
+    apply(current, RenderState());
+}
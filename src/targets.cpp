@@ -14,12 +14,23 @@
  * http://www.opensource.org/licenses/BSD-2-Clause
  */
 
+#define GL_GLEXT_PROTOTYPES 1
+
 #include "targets.hpp"
+#include "glstate.hpp"
+#include "lighting.hpp"
 
 using namespace std;
 
 
 
+const Material TargetRenderer::MATERIAL = {
+    { 1, 1, 1, 1 }, // default: .2,.2,.2,1
+    { 1, 1, 1, 1 }, // default: .8,.8,.8,1
+    { 0, 0, 0, 1 }, // default: 0,0,0,1
+    0 // default: 0, range [0-128]
+};
+
 vector<Target> targets;
 
 IRenderable* targetsRenderer = NULL;
@@ -35,10 +46,6 @@ Target::Target(float x, float y, float z, float size)
 {
 }
 
-Target::~Target()
-{
-}
-
 float Target::getX()
 {
     return x;
@@ -74,8 +81,8 @@ void Target::setHit()
 TargetRenderer::TargetRenderer(Target& target, GLuint name)
 : SelectableLeafRenderable(name, Any().set(target))
 , target(target)
-, renderRenderable(Matrix<float,4,1>((float[]){target.getX()-target.getSize()/2, target.getY()-target.getSize()/2, target.getZ(), 1}), MatrixHelper::unitAxisVector<float>(0)*target.getSize(), MatrixHelper::unitAxisVector<float>(1)*target.getSize(), 10, 10, (Rect){0,0,1,1}, true)
-, selectionRenderable(Matrix<float,4,1>((float[]){target.getX(), target.getY(), target.getZ(), 1}), MatrixHelper::unitAxisVector<float>(0)*target.getSize()/2.045, MatrixHelper::unitAxisVector<float>(1)*target.getSize()/2.045, 20)
+, renderRenderable(Matrix<float,4,1>(target.getX()-target.getSize()/2, target.getY()-target.getSize()/2, target.getZ(), 1), MatrixHelper::unitAxisVector<float>(0)*target.getSize(), MatrixHelper::unitAxisVector<float>(1)*target.getSize(), 10, 10, (Rect){0,0,1,1}, true)
+, selectionRenderable(Matrix<float,4,1>(target.getX(), target.getY(), target.getZ(), 1), MatrixHelper::unitAxisVector<float>(0)*target.getSize()/2.045, MatrixHelper::unitAxisVector<float>(1)*target.getSize()/2.045, 20)
 {
 }
 
@@ -93,23 +100,24 @@ void TargetRenderer::configure(GLenum renderingMode)
     if (target.isHit()) return;
     SelectableRenderable::configure(renderingMode);
     if (renderingMode == GL_RENDER) {
-        glEnable(GL_ALPHA_TEST);
+        GLStateCache::enable(GL_ALPHA_TEST);
         glAlphaFunc(GL_GREATER, 0.75f);
-        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_FALSE);
-
-        GLfloat mat_ambiant[] = { 1, 1, 1, 1 }; // default: .2,.2,.2,1
-        GLfloat mat_diffuse[] = { 1, 1, 1, 1 }; // default: .8,.8,.8,1
-        GLfloat mat_specular[] = { 0, 0, 0, 1 }; // default: 0,0,0,1
-        GLfloat mat_shininess = 0; // default: 0, range [0-128]
-        glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, mat_ambiant);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, mat_diffuse);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, mat_specular);
-        glMaterialf(GL_FRONT_AND_BACK, GL_SHININESS, mat_shininess);
+        GLStateCache::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_FALSE);
+        MATERIAL.apply();
     } else if (renderingMode == GL_SELECT) {
-        glDisable(GL_CULL_FACE);
+        GLStateCache::disable(GL_CULL_FACE);
     }
 }
 
+bool TargetRenderer::describeState(RenderState& state)
+{
+    if (target.isHit()) return false;
+    state.alphaThreshold = 0.75f;
+    state.writeAlpha = false;
+    state.material = &MATERIAL;
+    return true;
+}
+
 void TargetRenderer::render(GLenum renderingMode)
 {
     if (target.isHit()) return;
@@ -124,20 +132,150 @@ void TargetRenderer::render(GLenum renderingMode)
     }
 }
 
+BoundingVolume TargetRenderer::getBounds()
+{
+    if (target.isHit()) return BoundingVolume();
+    BoundingVolume rtn = renderRenderable.getBounds();
+    rtn.merge(selectionRenderable.getBounds());
+    return rtn;
+}
+
 void TargetRenderer::deconfigure(GLenum renderingMode)
 {
     if (target.isHit()) return;
     SelectableRenderable::deconfigure(renderingMode);
     if (renderingMode == GL_RENDER) {
-        glDisable(GL_ALPHA_TEST);
-        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        GLStateCache::disable(GL_ALPHA_TEST);
+        GLStateCache::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
     } else if (renderingMode == GL_SELECT) {
-        glEnable(GL_CULL_FACE);
+        GLStateCache::enable(GL_CULL_FACE);
     }
 }
 
 
 
+TargetBatchRenderer::TargetBatchRenderer(vector<Target>& targets)
+: CompositeRenderable()
+, targets(targets)
+, vertexBuffer(0)
+, instanceBuffer(0)
+, uploadedInstances()
+, instances()
+{
+}
+
+TargetBatchRenderer::~TargetBatchRenderer()
+{
+    if (vertexBuffer != 0) glDeleteBuffers(1, &vertexBuffer);
+    if (instanceBuffer != 0) glDeleteBuffers(1, &instanceBuffer);
+}
+
+bool TargetBatchRenderer::isInstanced(GLenum renderingMode)
+{
+    return renderingMode == GL_RENDER && PerPixelLighting::isInstancingAvailable();
+}
+
+void TargetBatchRenderer::updateInstances()
+{
+    instances.clear();
+    for (vector<Target>::iterator it = targets.begin() ; it < targets.end() ; it++) {
+        if (it->isHit()) continue;
+        instances.push_back(it->getX());
+        instances.push_back(it->getY());
+        instances.push_back(it->getZ());
+        instances.push_back(it->getSize());
+    }
+    if (instanceBuffer != 0 && instances == uploadedInstances) return;
+    if (instanceBuffer == 0) glGenBuffers(1, &instanceBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(GLfloat), instances.empty() ? NULL : &instances[0], GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    uploadedInstances = instances;
+}
+
+void TargetBatchRenderer::configure(GLenum renderingMode)
+{
+    if (!isInstanced(renderingMode)) return;
+    GLStateCache::enable(GL_ALPHA_TEST);
+    glAlphaFunc(GL_GREATER, 0.75f);
+    GLStateCache::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_FALSE);
+    TargetRenderer::MATERIAL.apply();
+}
+
+bool TargetBatchRenderer::describeState(RenderState& state)
+{
+    if (!isInstanced(GL_RENDER)) return true;
+    bool any = false;
+    for (vector<Target>::iterator it = targets.begin() ; it < targets.end() && !any ; it++)
+        any = !it->isHit();
+    if (!any) return false;
+    state.alphaThreshold = 0.75f;
+    state.writeAlpha = false;
+    state.material = &TargetRenderer::MATERIAL;
+    return true;
+}
+
+bool TargetBatchRenderer::isFlattened()
+{
+    return !isInstanced(GL_RENDER);
+}
+
+void TargetBatchRenderer::render(GLenum renderingMode)
+{
+    if (!isInstanced(renderingMode)) {
+        CompositeRenderable::render(renderingMode);
+        return;
+    }
+    updateInstances();
+    GLsizei count = uploadedInstances.size() / 4;
+    if (count == 0) return;
+    if (vertexBuffer == 0) {
+        // Unit square, as a counter-clockwise triangle fan, textured once
+        static const GLfloat vertices[] = {
+            0, 0, 0, 0, 0,
+            1, 0, 0, 1, 0,
+            1, 1, 0, 1, 1,
+            0, 1, 0, 0, 1
+        };
+        glGenBuffers(1, &vertexBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    }
+
+    GLint instance = PerPixelLighting::bindInstanced();
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 5 * sizeof(GLfloat), reinterpret_cast<const GLvoid*>(0));
+    glTexCoordPointer(2, GL_FLOAT, 5 * sizeof(GLfloat), reinterpret_cast<const GLvoid*>(3 * sizeof(GLfloat)));
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glEnableVertexAttribArray(instance);
+    glVertexAttribPointer(instance, 4, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<const GLvoid*>(0));
+    glVertexAttribDivisor(instance, 1);
+
+    // Double sided, the program reversing the normal of the back faces
+    glNormal3f(0, 0, 1);
+    GLStateCache::disable(GL_CULL_FACE);
+    glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, count);
+    GLStateCache::enable(GL_CULL_FACE);
+
+    glVertexAttribDivisor(instance, 0);
+    glDisableVertexAttribArray(instance);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    PerPixelLighting::unbindInstanced();
+}
+
+void TargetBatchRenderer::deconfigure(GLenum renderingMode)
+{
+    if (!isInstanced(renderingMode)) return;
+    GLStateCache::disable(GL_ALPHA_TEST);
+    GLStateCache::colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+}
+
+
+
 void initTargets(Texture texture)
 {
     targets.push_back(Target( 0.0,  0.0, -4.0, 4.0));
@@ -166,11 +304,13 @@ void initTargets(Texture texture)
 
     TexturerCompositeRenderable* targetsTexturer = new TexturerCompositeRenderable(texture);
     SelectableCompositeRenderable* selectable = new SelectableCompositeRenderable(1, Any()); //1=targets
+    TargetBatchRenderer* batch = new TargetBatchRenderer(targets);
     GLuint name = 1;
     for (vector<Target>::iterator it = targets.begin() ; it < targets.end() ; it++) {
-        selectable->components.push_back(new TargetRenderer(*it, name));
+        batch->components.push_back(new TargetRenderer(*it, name));
         name++;
     }
+    selectable->components.push_back(batch);
     targetsTexturer->components.push_back(selectable);
     targetsRenderer = targetsTexturer;
 }
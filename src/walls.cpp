@@ -23,6 +23,13 @@ using namespace std;
 const float Wall::STANDARD_TEXTURE_SCALE = 2;
 const float Wall::STANDARD_TESSELATION_SCALE = 10;
 
+const Material WallRenderer::MATERIAL = {
+    { 1, 1, 1, 1 }, // default: .2,.2,.2,1
+    { 1, 1, 1, 1 }, // default: .8,.8,.8,1
+    { 1, 1, 1, 1 }, // default: 0,0,0,1
+    40 // default: 0, range [0-128]
+};
+
 vector<Wall> walls;
 
 IRenderable* wallsRenderer = NULL;
@@ -38,10 +45,6 @@ Wall::Wall(Matrix<float,4,1> corner, Matrix<float,4,1> axisA, Matrix<float,4,1>a
 {
 }
 
-Wall::~Wall()
-{
-}
-
 Matrix<float,4,1> Wall::getCorner() const
 {
     return corner;
@@ -73,8 +76,8 @@ Matrix<float,4,1> Wall::projectOnto(Matrix<float,4,1> point) const
     Matrix<float,1,4> ptT (pt.values);
     float aNorm = axisA.norm();
     float bNorm = axisB.norm();
-    Matrix<float,4,1> axisA4 ((float[]){axisA[0], axisA[1], axisA[2], 1});
-    Matrix<float,4,1> axisB4 ((float[]){axisB[0], axisB[1], axisB[2], 1});
+    Matrix<float,4,1> axisA4 (axisA[0], axisA[1], axisA[2], 1);
+    Matrix<float,4,1> axisB4 (axisB[0], axisB[1], axisB[2], 1);
     float a = (ptT * axisA4/aNorm/aNorm)[0];
     float b = (ptT * axisB4/bNorm/bNorm)[0];
     Matrix<float,4,1> rtn = corner + axisA4 * a + axisB4 * b;
@@ -87,11 +90,54 @@ Matrix<float,2,1> Wall::inWallCoordinates(Matrix<float,4,1> point) const
     Matrix<float,1,4> ptT (pt.values);
     float aNorm = axisA.norm();
     float bNorm = axisB.norm();
-    Matrix<float,4,1> axisA4 ((float[]){axisA[0], axisA[1], axisA[2], 1});
-    Matrix<float,4,1> axisB4 ((float[]){axisB[0], axisB[1], axisB[2], 1});
+    Matrix<float,4,1> axisA4 (axisA[0], axisA[1], axisA[2], 1);
+    Matrix<float,4,1> axisB4 (axisB[0], axisB[1], axisB[2], 1);
     float a = (ptT * axisA4/aNorm/aNorm)[0];
     float b = (ptT * axisB4/bNorm/bNorm)[0];
-    Matrix<float,2,1> rtn ((float[]){a,b});
+    Matrix<float,2,1> rtn (a,b);
+    return rtn;
+}
+
+Matrix<float,4,4> Wall::getProjectionTransformation() const
+{
+    /*
+     * p' = corner + axisA * (axisA . (p - corner)) / |axisA|² + axisB * (axisB . (p - corner)) / |axisB|²
+     * Where the linear part L = axisA axisA^T / |axisA|² + axisB axisB^T / |axisB|²,
+     * and the translation is corner - L corner.
+     */
+    Matrix<float,4,4> coordinates = getWallCoordinatesTransformation();
+    Matrix<float,4,4> rtn = MatrixHelper::identity<float>();
+    for (unsigned int c = 0 ; c < 4 ; ++c) {
+        for (unsigned int l = 0 ; l < 3 ; ++l) {
+            rtn(l,c) = axisA[l] * coordinates(0,c) + axisB[l] * coordinates(1,c);
+        }
+    }
+    for (unsigned int l = 0 ; l < 3 ; ++l) {
+        rtn(l,3) += corner[l];
+    }
+    return rtn;
+}
+
+Matrix<float,4,4> Wall::getWallCoordinatesTransformation() const
+{
+    /*
+     *  / axisA^T / |axisA|²   -(axisA . corner) / |axisA|² \
+     * |  axisB^T / |axisB|²   -(axisB . corner) / |axisB|²  |
+     * |          0                       0                  |
+     *  \         0                       1                 /
+     */
+    float aNorm = axisA.norm();
+    float bNorm = axisB.norm();
+    Matrix<float,4,4> rtn = MatrixHelper::identity<float>();
+    rtn(2,2) = 0;
+    rtn(0,3) = 0;
+    rtn(1,3) = 0;
+    for (unsigned int i = 0 ; i < 3 ; ++i) {
+        rtn(0,i) = axisA[i]/aNorm/aNorm;
+        rtn(1,i) = axisB[i]/bNorm/bNorm;
+        rtn(0,3) -= rtn(0,i) * corner[i];
+        rtn(1,3) -= rtn(1,i) * corner[i];
+    }
     return rtn;
 }
 
@@ -112,22 +158,26 @@ void WallRenderer::configure(GLenum renderingMode)
 {
     SelectableRenderable::configure(renderingMode);
     if (renderingMode == GL_RENDER) {
-        GLfloat mat_ambiant[] = { 1, 1, 1, 1 }; // default: .2,.2,.2,1
-        GLfloat mat_diffuse[] = { 1, 1, 1, 1 }; // default: .8,.8,.8,1
-        GLfloat mat_specular[] = { 1, 1, 1, 1 }; // default: 0,0,0,1
-        GLfloat mat_shininess = 40; // default: 0, range [0-128]
-        glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, mat_ambiant);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, mat_diffuse);
-        glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, mat_specular);
-        glMaterialf(GL_FRONT_AND_BACK, GL_SHININESS, mat_shininess);
+        MATERIAL.apply();
     }
 }
 
+bool WallRenderer::describeState(RenderState& state)
+{
+    state.material = &MATERIAL;
+    return true;
+}
+
 void WallRenderer::render(GLenum renderingMode)
 {
     renderRenderable.fullRender(renderingMode);
 }
 
+BoundingVolume WallRenderer::getBounds()
+{
+    return renderRenderable.getBounds();
+}
+
 void WallRenderer::deconfigure(GLenum renderingMode)
 {
     SelectableRenderable::deconfigure(renderingMode);
@@ -137,13 +187,18 @@ void WallRenderer::deconfigure(GLenum renderingMode)
 
 void initWalls(Texture texture)
 {
-    walls.push_back(Wall(Matrix<float,4,1>((float[]){-1,-1,-2,1}), Matrix<float,4,1>((float[]){ 2,0,0,1}), Matrix<float,4,1>((float[]){0,2,0,1})));
-    walls.push_back(Wall(Matrix<float,4,1>((float[]){ 1,-1, 2,1}), Matrix<float,4,1>((float[]){-2,0,0,1}), Matrix<float,4,1>((float[]){0,2,0,1})));
-
-    walls.push_back(Wall(Matrix<float,4,1>((float[]){-1,-1,-2,1}), Matrix<float,4,1>((float[]){0,0, 4,1}), Matrix<float,4,1>((float[]){2,0,0,1})));
-    walls.push_back(Wall(Matrix<float,4,1>((float[]){-1, 1, 2,1}), Matrix<float,4,1>((float[]){0,0,-4,1}), Matrix<float,4,1>((float[]){2,0,0,1})));
-    walls.push_back(Wall(Matrix<float,4,1>((float[]){-1,-1, 2,1}), Matrix<float,4,1>((float[]){0,0,-4,1}), Matrix<float,4,1>((float[]){0,2,0,1})));
-    walls.push_back(Wall(Matrix<float,4,1>((float[]){ 1,-1,-2,1}), Matrix<float,4,1>((float[]){0,0, 4,1}), Matrix<float,4,1>((float[]){0,2,0,1})));
+    // Corner, axis A and axis B of each wall, built at compile time
+    static constexpr Matrix<float,4,1> definitions[][3] = {
+        { Matrix<float,4,1>(-1,-1,-2,1), Matrix<float,4,1>( 2,0,0,1), Matrix<float,4,1>(0,2,0,1) },
+        { Matrix<float,4,1>( 1,-1, 2,1), Matrix<float,4,1>(-2,0,0,1), Matrix<float,4,1>(0,2,0,1) },
+
+        { Matrix<float,4,1>(-1,-1,-2,1), Matrix<float,4,1>(0,0, 4,1), Matrix<float,4,1>(2,0,0,1) },
+        { Matrix<float,4,1>(-1, 1, 2,1), Matrix<float,4,1>(0,0,-4,1), Matrix<float,4,1>(2,0,0,1) },
+        { Matrix<float,4,1>(-1,-1, 2,1), Matrix<float,4,1>(0,0,-4,1), Matrix<float,4,1>(0,2,0,1) },
+        { Matrix<float,4,1>( 1,-1,-2,1), Matrix<float,4,1>(0,0, 4,1), Matrix<float,4,1>(0,2,0,1) }
+    };
+    for (unsigned int i = 0 ; i < sizeof(definitions)/sizeof(definitions[0]) ; ++i)
+        walls.push_back(Wall(definitions[i][0], definitions[i][1], definitions[i][2]));
 
     TexturerCompositeRenderable* wallsTexturer = new TexturerCompositeRenderable(texture);
     SelectableCompositeRenderable* selectable = new SelectableCompositeRenderable(2, Any()); //2=walls
@@ -153,5 +208,6 @@ void initWalls(Texture texture)
         name++;
     }
     wallsTexturer->components.push_back(selectable);
-    wallsRenderer = wallsTexturer;
+    // The walls never change, record them once
+    wallsRenderer = new CompiledRenderable(wallsTexturer);
 }
@@ -0,0 +1,77 @@
+/**
+ * @file framebudget_bench.cpp
+ *
+ * @brief Simulations of the frame budget controller, fed with steady rendering times.
+ *
+ * Each simulation is printed as a single CSV line:
+ * <tt>benchmark,build,time_ratio,frames,depth</tt>,
+ * where \c time_ratio is the rendering time fed for each frame, relatively to the budget,
+ * and \c depth is the depth budget picked after the last frame, starting from the maximum depth.
+ * Lines starting with \c # are comments.
+ *
+ * The program fails if a rendering time within the budget cuts the recursion shallower,
+ * or if the recursion does not get back to the maximum depth once the rendering is fast again.
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2011 Olivier Favre
+ *
+ * This file is part of Breach.
+ *
+ * Licensed under the Simplified BSD License,
+ * for details please see LICENSE file or the website
+ * http://www.opensource.org/licenses/BSD-2-Clause
+ */
+
+#include "framebudget.hpp"
+
+#include <cassert>
+#include <cstdio>
+
+#ifdef __OPTIMIZE__
+//! @brief Name of the build type, as reported in the results.
+#define BUILD_NAME "release"
+#else
+//! @brief Name of the build type, as reported in the results.
+#define BUILD_NAME "debug"
+#endif
+
+//! @brief Time available for a frame, in seconds.
+#define BUDGET (1.0/60)
+//! @brief Maximum recursion depth of the simulations.
+#define MAX_DEPTH 3
+//! @brief Number of frames of each simulation, long enough for the averaged time to settle.
+#define FRAMES 300
+
+/**
+ * @brief Feeds the controller the same rendering time for each frame, and prints the resulting depth budget.
+ *
+ * @param name  Name of the simulation
+ * @param ratio Rendering time of each frame, relatively to the budget
+ * @param depth Depth budget of the first frame
+ * @return The depth budget picked after the last frame.
+ */
+unsigned int simulate(const char* name, double ratio, unsigned int depth) {
+    for (unsigned int i = 0 ; i < FRAMES ; ++i)
+        depth = FrameBudget::addFrame(ratio * BUDGET, depth, MAX_DEPTH);
+    printf("%s,%s,%.2f,%u,%u\n", name, BUILD_NAME, ratio, FRAMES, depth);
+    return depth;
+}
+
+int main() {
+    printf("# benchmark,build,time_ratio,frames,depth\n");
+    FrameBudget::setBudget(BUDGET);
+
+    // Within the budget, up to being exactly on it, the recursion is never cut
+    assert(simulate("steady", 0.3, MAX_DEPTH) == MAX_DEPTH);
+    assert(simulate("steady", 0.6, MAX_DEPTH) == MAX_DEPTH);
+    assert(simulate("steady", 0.9, MAX_DEPTH) == MAX_DEPTH);
+    assert(simulate("steady", 1.0, MAX_DEPTH) == MAX_DEPTH);
+
+    // Over the budget, the recursion is cut, and gets back to the maximum depth once the rendering is fast again
+    unsigned int depth = simulate("overload", 1.5, MAX_DEPTH);
+    assert(depth < MAX_DEPTH);
+    assert(simulate("recovery", 0.3, depth) == MAX_DEPTH);
+
+    return 0;
+}
@@ -0,0 +1,201 @@
+/**
+ * @file matrix_bench.cpp
+ *
+ * @brief Micro-benchmarks for the matrix library.
+ *
+ * Each benchmark is printed as a single CSV line:
+ * <tt>benchmark,value,size,build,iterations,ns_per_op,ops_per_sec</tt>,
+ * where \c build is \c release for optimized builds and \c debug otherwise.
+ * Lines starting with \c # are comments.
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2011 Olivier Favre
+ *
+ * This file is part of Breach.
+ *
+ * Licensed under the Simplified BSD License,
+ * for details please see LICENSE file or the website
+ * http://www.opensource.org/licenses/BSD-2-Clause
+ */
+
+#include "matrix.hpp"
+#include "vectors.hpp"
+#include "walls.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+//! @brief Minimum measured duration of each benchmark, in nanoseconds.
+#define MIN_DURATION_NS 100000000.0
+//! @brief Number of elements transformed by each batched transformation.
+#define BATCH_SIZE 1024
+
+#ifdef __OPTIMIZE__
+//! @brief Name of the build type, as reported in the results.
+#define BUILD_NAME "release"
+#else
+//! @brief Name of the build type, as reported in the results.
+#define BUILD_NAME "debug"
+#endif
+
+/**
+ * @brief Prevents the compiler from optimizing away the computation of \a value.
+ */
+template <typename T>
+inline void escape(T &value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+//! @brief Returns the name of the given value type.
+template <typename Value> const char* valueName();
+template <> const char* valueName<float>() { return "float"; }
+template <> const char* valueName<double>() { return "double"; }
+
+/**
+ * @brief Runs \a operation enough times to last at least \link MIN_DURATION_NS \endlink, and prints the results.
+ *
+ * @param name       Name of the benchmark
+ * @param value      Name of the value type
+ * @param size       Name of the matrix size
+ * @param operation  Functor executing a single operation
+ * @param opsPerCall Number of operations executed by each call to \a operation
+ */
+template <class Operation>
+void bench(const char* name, const char* value, const char* size, Operation operation, unsigned long opsPerCall = 1) {
+    unsigned long iterations = 1;
+    double elapsed = 0;
+    while (true) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (unsigned long i = 0 ; i < iterations ; ++i)
+            operation();
+        elapsed = std::chrono::duration<double,std::nano>(std::chrono::steady_clock::now() - start).count();
+        if (elapsed >= MIN_DURATION_NS) break;
+        iterations *= 2;
+    }
+    double nsPerOp = elapsed / (iterations * opsPerCall);
+    printf("%s,%s,%s,%s,%lu,%.3f,%.0f\n", name, value, size, BUILD_NAME, iterations * opsPerCall, nsPerOp, 1e9 / nsPerOp);
+}
+
+/**
+ * @brief Fills the given matrix with random values in [-1;1].
+ */
+template <typename Value, unsigned int lines, unsigned int cols>
+Matrix<Value,lines,cols> randomMatrix() {
+    Matrix<Value,lines,cols> rtn;
+    for (unsigned int i = 0 ; i < lines*cols ; ++i)
+        rtn[i] = rand() / (Value)RAND_MAX * 2 - 1;
+    return rtn;
+}
+
+/**
+ * @brief Benchmarks the operations available for any matrix size.
+ *
+ * The product multiplies by a square matrix, so that it is defined for every size.
+ */
+template <typename Value, unsigned int lines, unsigned int cols>
+void benchGeneric(const char* size) {
+    Matrix<Value,lines,cols> a = randomMatrix<Value,lines,cols>();
+    Matrix<Value,lines,cols> b = randomMatrix<Value,lines,cols>();
+    Matrix<Value,cols,cols> square = randomMatrix<Value,cols,cols>();
+    Matrix<Value,lines,cols> result;
+    Value scalar = 1.5;
+    double norm;
+    bench("product", valueName<Value>(), size, [&]() { escape(a); escape(square); result = a * square; escape(result); });
+    bench("add", valueName<Value>(), size, [&]() { escape(a); escape(b); result = a + b; escape(result); });
+    bench("scale", valueName<Value>(), size, [&]() { escape(a); escape(scalar); result = a * scalar; escape(result); });
+    bench("norm", valueName<Value>(), size, [&]() { escape(a); norm = a.norm(); escape(norm); });
+    bench("normFull", valueName<Value>(), size, [&]() { escape(a); norm = a.normFull(); escape(norm); });
+}
+
+/**
+ * @brief Benchmarks the operations specific to 4D vectors.
+ */
+template <typename Value>
+void bench4x1() {
+    Matrix<Value,4,1> u = randomMatrix<Value,4,1>();
+    Matrix<Value,4,1> v = randomMatrix<Value,4,1>();
+    Matrix<Value,4,4> m = randomMatrix<Value,4,4>();
+    Matrix<Value,4,1> result;
+    bench("cross", valueName<Value>(), "4x1", [&]() { escape(u); escape(v); result = u * v; escape(result); });
+    bench("transform", valueName<Value>(), "4x1", [&]() { escape(m); escape(u); result = m * u; escape(result); });
+
+    static Value x[BATCH_SIZE], y[BATCH_SIZE], z[BATCH_SIZE];
+    for (unsigned int i = 0 ; i < BATCH_SIZE ; ++i) {
+        x[i] = rand() / (Value)RAND_MAX;
+        y[i] = rand() / (Value)RAND_MAX;
+        z[i] = rand() / (Value)RAND_MAX;
+    }
+    bench("transformBatch", valueName<Value>(), "4x1", [&]() {
+        escape(m);
+        MatrixHelper::transformBatch(m, BATCH_SIZE, x, y, z, static_cast<Value>(1), x, y, z);
+        escape(x);
+    }, BATCH_SIZE);
+}
+
+/**
+ * @brief Benchmarks the operations specific to 4x4 transformations.
+ */
+template <typename Value>
+void bench4x4() {
+    Matrix<Value,4,1> axis = randomMatrix<Value,4,1>();
+    Matrix<Value,4,4> m = randomMatrix<Value,4,4>();
+    Matrix<Value,4,4> rigid = MatrixHelper::rotation(.5, axis);
+    Matrix<Value,4,4> result;
+    double angle = .5;
+    bench("rotation", valueName<Value>(), "4x4", [&]() { escape(axis); escape(angle); result = MatrixHelper::rotation(angle, axis); escape(result); });
+    bench("affineInverse", valueName<Value>(), "4x4", [&]() { escape(rigid); result = MatrixHelper::affineInverse(rigid); escape(result); });
+    bench("inverse", valueName<Value>(), "4x4", [&]() { escape(m); result = MatrixHelper::inverse(m); escape(result); });
+}
+
+/**
+ * @brief Benchmarks the dedicated 3D vectors, against their 4D matrices counterparts.
+ */
+void benchVectors() {
+    Matrix<float,4,1> u = randomMatrix<float,4,1>();
+    Matrix<float,4,1> v = randomMatrix<float,4,1>();
+    Matrix<float,4,1> matrixResult;
+    Vec3f a (u), b (v), result;
+    float scalar;
+    bench("normalize", "float", "4x1", [&]() { escape(u); matrixResult = u / u.norm(); escape(matrixResult); });
+    bench("normalize", "float", "Vec3f", [&]() { escape(a); result = normalize(a); escape(result); });
+    bench("dot", "float", "Vec3f", [&]() { escape(a); escape(b); scalar = dot(a, b); escape(scalar); });
+    bench("cross", "float", "Vec3f", [&]() { escape(a); escape(b); result = cross(a, b); escape(result); });
+    bench("lerp", "float", "Vec3f", [&]() { escape(a); escape(b); result = lerp(a, b, .25f); escape(result); });
+}
+
+/**
+ * @brief Benchmarks the projection of a point onto a wall.
+ */
+void benchWall() {
+    Wall wall (Matrix<float,4,1>(-1,-1,-2,1), Matrix<float,4,1>(2,0,0,1), Matrix<float,4,1>(0,2,0,1));
+    Matrix<float,4,1> point (.3f, .2f, 1, 1);
+    Matrix<float,4,1> projected;
+    Matrix<float,2,1> coordinates;
+    bench("Wall::projectOnto", "float", "4x1", [&]() { escape(wall); escape(point); projected = wall.projectOnto(point); escape(projected); });
+    bench("Wall::inWallCoordinates", "float", "4x1", [&]() { escape(wall); escape(point); coordinates = wall.inWallCoordinates(point); escape(coordinates); });
+}
+
+/**
+ * @brief Executes the micro-benchmarks of the Matrix library.
+ */
+int main() {
+    srand(42);
+    printf("# benchmark,value,size,build,iterations,ns_per_op,ops_per_sec\n");
+
+    benchGeneric<float,2,1>("2x1");
+    benchGeneric<float,4,1>("4x1");
+    benchGeneric<float,4,4>("4x4");
+    benchGeneric<double,2,1>("2x1");
+    benchGeneric<double,4,1>("4x1");
+    benchGeneric<double,4,4>("4x4");
+    bench4x1<float>();
+    bench4x1<double>();
+    bench4x4<float>();
+    bench4x4<double>();
+    benchVectors();
+    benchWall();
+
+    return 0;
+}
@@ -0,0 +1,115 @@
+/**
+ * @file bounds_test.cpp
+ *
+ * @brief Unit tests for the bounding volumes and frustums.
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2011 Olivier Favre
+ *
+ * This file is part of Breach.
+ *
+ * Licensed under the Simplified BSD License,
+ * for details please see LICENSE file or the website
+ * http://www.opensource.org/licenses/BSD-2-Clause
+ */
+
+#include "bounds.hpp"
+
+#include <cassert>
+#include <cmath>
+
+/**
+ * @brief Tells whether two values are equal, within a small tolerance.
+ */
+bool near(float a, float b) {
+    return std::fabs(a - b) < 1e-5f;
+}
+
+/**
+ * @brief Builds a box volume, centered on the given point, with the given half extent.
+ */
+BoundingVolume cube(float x, float y, float z, float halfExtent) {
+    return BoundingVolume(Matrix<float,4,1>(x-halfExtent, y-halfExtent, z-halfExtent, 1), Matrix<float,4,1>(x+halfExtent, y+halfExtent, z+halfExtent, 1));
+}
+
+/**
+ * @brief Executes unit tests for the bounding volumes and frustums.
+ */
+int main() {
+    // Empty and infinite volumes
+    {
+        BoundingVolume empty;
+        assert(empty.isEmpty() && !empty.isInfinite());
+        BoundingVolume everything = BoundingVolume::everything();
+        assert(!everything.isEmpty() && everything.isInfinite());
+
+        BoundingVolume v = empty;
+        v.merge(cube(1, 2, 3, 1));
+        assert(!v.isEmpty() && near(v.getCenter()[0], 1) && near(v.getRadius(), std::sqrt(3.f)));
+        v.merge(empty);
+        assert(near(v.getRadius(), std::sqrt(3.f)));
+        v.merge(everything);
+        assert(v.isInfinite());
+        assert(empty.transform(MatrixHelper::identity<float>()).isEmpty());
+    }
+
+    // Merging
+    {
+        BoundingVolume v = cube(0, 0, 0, 1);
+        v.merge(cube(4, 0, 0, 1));
+        assert(near(v.getMinimum()[0], -1) && near(v.getMaximum()[0], 5));
+        assert(near(v.getMinimum()[1], -1) && near(v.getMaximum()[1], 1));
+        // Circumscribing the merged box is tighter than enclosing both spheres, of radius 2+sqrt(3)
+        assert(near(v.getCenter()[0], 2) && near(v.getRadius(), std::sqrt(11.f)));
+        // An enclosed volume changes nothing
+        v.merge(cube(2, 0, 0, .5f));
+        assert(near(v.getCenter()[0], 2) && near(v.getRadius(), std::sqrt(11.f)));
+    }
+
+    // Transformation, along with a rotation of 90 degrees around Z, a scaling by 2, and a translation
+    {
+        Matrix<float,4,4> transformation (0,2,0,0, -2,0,0,0, 0,0,2,0, 10,20,30,1);
+        BoundingVolume v = BoundingVolume(Matrix<float,4,1>(0, 0, 0, 1), Matrix<float,4,1>(1, 2, 0, 1)).transform(transformation);
+        assert(near(v.getMinimum()[0], 6)  && near(v.getMaximum()[0], 10));
+        assert(near(v.getMinimum()[1], 20) && near(v.getMaximum()[1], 22));
+        assert(near(v.getMinimum()[2], 30) && near(v.getMaximum()[2], 30));
+        assert(near(v.getCenter()[0], 8) && near(v.getCenter()[1], 21) && near(v.getCenter()[2], 30));
+        assert(near(v.getRadius(), std::sqrt(5.f)));
+    }
+
+    // Frustum of a symmetric perspective projection, looking down -Z, from 1 to 10
+    {
+        float n = 1, f = 10;
+        Matrix<float,4,4> projection (1,0,0,0, 0,1,0,0, 0,0,-(f+n)/(f-n),-1, 0,0,-2*f*n/(f-n),0);
+        Frustum frustum (projection);
+        assert(frustum.classify(cube(0, 0, -5, 1)) == Frustum::INSIDE);
+        assert(frustum.classify(cube(0, 0, 5, 1)) == Frustum::OUTSIDE);
+        assert(frustum.classify(cube(0, 0, -20, 1)) == Frustum::OUTSIDE);
+        assert(frustum.classify(cube(0, 0, -10, 1)) == Frustum::INTERSECTING);
+        assert(frustum.classify(cube(8, 0, -5, 1)) == Frustum::OUTSIDE);
+        assert(frustum.classify(cube(5, 0, -5, 1)) == Frustum::INTERSECTING);
+        assert(frustum.classify(BoundingVolume()) == Frustum::OUTSIDE);
+        assert(frustum.classify(BoundingVolume::everything()) == Frustum::INTERSECTING);
+        // The sphere of this flat box crosses the right plane, but the box does not
+        BoundingVolume flat (Matrix<float,4,1>(5.5f, -3, -5, 1), Matrix<float,4,1>(6.5f, 3, -5, 1));
+        assert(frustum.classify(flat) == Frustum::OUTSIDE);
+
+        // Moving the camera to x=10 is moving the scene to x=-10
+        Matrix<float,4,4> view = MatrixHelper::identity<float>();
+        view(0,3) = -10;
+        Matrix<float,4,4> clip = projection * view;
+        Frustum moved (clip);
+        assert(moved.classify(cube(10, 0, -5, 1)) == Frustum::INSIDE);
+        assert(moved.classify(cube(0, 0, -5, 1)) == Frustum::OUTSIDE);
+    }
+
+    // Default frustum
+    {
+        Frustum frustum;
+        assert(frustum.classify(cube(0, 0, 0, .5f)) == Frustum::INSIDE);
+        assert(frustum.classify(cube(0, 0, 3, .5f)) == Frustum::OUTSIDE);
+    }
+
+    return 0;
+}
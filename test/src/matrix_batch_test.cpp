@@ -0,0 +1,133 @@
+/**
+ * @file matrix_batch_test.cpp
+ *
+ * @brief Unit tests for the batched transformations of the matrix library.
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2011 Olivier Favre
+ *
+ * This file is part of Breach.
+ *
+ * Licensed under the Simplified BSD License,
+ * for details please see LICENSE file or the website
+ * http://www.opensource.org/licenses/BSD-2-Clause
+ */
+
+#include "matrix.hpp"
+
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+
+//! @brief Maximum number of elements transformed at once, covering several full batches and every remainder.
+#define MAX_COUNT 35
+
+//! @brief Maximum tolerated distance to the matrix product, in ULP of the accumulated magnitude, as documented in matrix.hpp.
+#define MAX_ULP 4
+
+/**
+ * @brief Whether \a a and \a b are within the documented tolerance.
+ *
+ * @param a         The batched result
+ * @param b         The matrix product result
+ * @param magnitude The sum of the absolute values of the products accumulated to obtain \a a and \a b.
+ */
+bool withinTolerance(float a, float b, float magnitude) {
+    magnitude = fabsf(magnitude);
+    return fabsf(a - b) <= MAX_ULP * (nextafterf(magnitude, INFINITY) - magnitude);
+}
+
+/**
+ * @brief Returns a copy of \a m with each value replaced by its absolute value.
+ */
+template <unsigned int cols>
+Matrix<float,4,cols> absolute(Matrix<float,4,cols> m) {
+    for (unsigned int i = 0 ; i < 4*cols ; ++i) m[i] = fabsf(m[i]);
+    return m;
+}
+
+/**
+ * @brief Returns a random value in [-range;+range].
+ */
+float randomValue(float range) {
+    return (rand() / (float)RAND_MAX * 2 - 1) * range;
+}
+
+/**
+ * @brief Executes unit tests for the batched transformations of the Matrix library.
+ */
+int main() {
+    srand(42);
+
+    for (unsigned int count = 0 ; count <= MAX_COUNT ; ++count) {
+        Matrix<float,4,4> m;
+        for (unsigned int i = 0 ; i < 16 ; ++i)
+            m[i] = randomValue(10);
+        float x[MAX_COUNT], y[MAX_COUNT], z[MAX_COUNT], w[MAX_COUNT];
+        for (unsigned int i = 0 ; i < count ; ++i) {
+            x[i] = randomValue(100);
+            y[i] = randomValue(100);
+            z[i] = randomValue(100);
+            w[i] = randomValue(2);
+        }
+
+        // Points and directions, against the matrix product
+        for (unsigned int point = 0 ; point < 2 ; ++point) {
+            float outX[MAX_COUNT], outY[MAX_COUNT], outZ[MAX_COUNT];
+            MatrixHelper::transformBatch(m, count, x, y, z, (float)point, outX, outY, outZ);
+            for (unsigned int i = 0 ; i < count ; ++i) {
+                float values[4] = { x[i], y[i], z[i], (float)point };
+                Matrix<float,4,1> v;
+                v.take(values);
+                Matrix<float,4,1> expected = m * v;
+                Matrix<float,4,1> magnitude = absolute(m) * absolute(v);
+                assert(withinTolerance(outX[i], expected[0], magnitude[0]));
+                assert(withinTolerance(outY[i], expected[1], magnitude[1]));
+                assert(withinTolerance(outZ[i], expected[2], magnitude[2]));
+            }
+        }
+
+        // Full 4D transformation
+        {
+            float outX[MAX_COUNT], outY[MAX_COUNT], outZ[MAX_COUNT], outW[MAX_COUNT];
+            MatrixHelper::transformBatch(m, count, x, y, z, w, outX, outY, outZ, outW);
+            for (unsigned int i = 0 ; i < count ; ++i) {
+                float values[4] = { x[i], y[i], z[i], w[i] };
+                Matrix<float,4,1> v;
+                v.take(values);
+                Matrix<float,4,1> expected = m * v;
+                Matrix<float,4,1> magnitude = absolute(m) * absolute(v);
+                assert(withinTolerance(outX[i], expected[0], magnitude[0]));
+                assert(withinTolerance(outY[i], expected[1], magnitude[1]));
+                assert(withinTolerance(outZ[i], expected[2], magnitude[2]));
+                assert(withinTolerance(outW[i], expected[3], magnitude[3]));
+            }
+        }
+
+        // In place, with the generic double precision version
+        {
+            Matrix<double,4,4> md;
+            double xd[MAX_COUNT], yd[MAX_COUNT], zd[MAX_COUNT];
+            for (unsigned int i = 0 ; i < 16 ; ++i)
+                md[i] = m[i];
+            for (unsigned int i = 0 ; i < count ; ++i) {
+                xd[i] = x[i];
+                yd[i] = y[i];
+                zd[i] = z[i];
+            }
+            MatrixHelper::transformBatch(md, count, xd, yd, zd, 1.0, xd, yd, zd);
+            for (unsigned int i = 0 ; i < count ; ++i) {
+                double values[4] = { x[i], y[i], z[i], 1 };
+                Matrix<double,4,1> v;
+                v.take(values);
+                Matrix<double,4,1> expected = md * v;
+                assert(fabs(xd[i] - expected[0]) <= 1e-9);
+                assert(fabs(yd[i] - expected[1]) <= 1e-9);
+                assert(fabs(zd[i] - expected[2]) <= 1e-9);
+            }
+        }
+    }
+
+    return 0;
+}
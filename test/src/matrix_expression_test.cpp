@@ -0,0 +1,84 @@
+/**
+ * @file matrix_expression_test.cpp
+ *
+ * @brief Unit tests for the element-wise expressions of the matrix library.
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2011 Olivier Favre
+ *
+ * This file is part of Breach.
+ *
+ * Licensed under the Simplified BSD License,
+ * for details please see LICENSE file or the website
+ * http://www.opensource.org/licenses/BSD-2-Clause
+ */
+
+#include "matrix.hpp"
+
+#include <cassert>
+
+/**
+ * @brief Executes unit tests for the element-wise expressions of the Matrix library.
+ */
+int main() {
+    float a_values[4] = { 1, 2, 3, 1 };
+    float b_values[4] = { 10, 20, 30, 1 };
+    Matrix<float,4,1> a, b;
+    a.take(a_values);
+    b.take(b_values);
+
+    // Simple operations
+    {
+        Matrix<float,4,1> sum = a + b;
+        Matrix<float,4,1> difference = b - a;
+        Matrix<float,4,1> product = a * 2;
+        Matrix<float,4,1> quotient = b / 10;
+        Matrix<float,4,1> scalarSum = a + 1;
+        Matrix<float,4,1> scalarDifference = a - 1;
+        for (unsigned int i = 0 ; i < 4 ; ++i) {
+            assert(sum[i] == a_values[i] + b_values[i]);
+            assert(difference[i] == b_values[i] - a_values[i]);
+            assert(product[i] == a_values[i] * 2);
+            assert(quotient[i] == b_values[i] / 10);
+            assert(scalarSum[i] == a_values[i] + 1);
+            assert(scalarDifference[i] == a_values[i] - 1);
+        }
+    }
+
+    // Composed expression, evaluated cell by cell
+    {
+        Matrix<float,4,1> composed = a + (b*2 - a*3 + b) * 0.5f;
+        for (unsigned int i = 0 ; i < 4 ; ++i)
+            assert(composed[i] == a_values[i] + (b_values[i]*2 - a_values[i]*3 + b_values[i]) * 0.5f);
+        // Direct cell access to an expression
+        assert((a + b)[2] == a_values[2] + b_values[2]);
+    }
+
+    // Mixing with non element-wise operations (cross product)
+    {
+        Matrix<float,4,1> x = MatrixHelper::unitAxisVector<float>(0);
+        Matrix<float,4,1> y = MatrixHelper::unitAxisVector<float>(1);
+        Matrix<float,4,1> mixed = a + x*y*2;
+        assert(mixed[0] == a_values[0]);
+        assert(mixed[1] == a_values[1]);
+        assert(mixed[2] == a_values[2] + 2);
+    }
+
+    // Assigning an expression referencing the assigned matrix
+    {
+        Matrix<float,4,1> c = a;
+        c = c + (b - c) * 2;
+        for (unsigned int i = 0 ; i < 4 ; ++i)
+            assert(c[i] == a_values[i] + (b_values[i] - a_values[i]) * 2);
+    }
+
+    // Scalar conversion, as with a double norm
+    {
+        Matrix<float,4,1> normalized = b / b.norm();
+        for (unsigned int i = 0 ; i < 4 ; ++i)
+            assert(normalized[i] == b_values[i] / static_cast<float>(b.norm()));
+    }
+
+    return 0;
+}
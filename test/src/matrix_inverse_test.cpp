@@ -0,0 +1,130 @@
+/**
+ * @file matrix_inverse_test.cpp
+ *
+ * @brief Unit tests for the inverses of the matrix library.
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2011 Olivier Favre
+ *
+ * This file is part of Breach.
+ *
+ * Licensed under the Simplified BSD License,
+ * for details please see LICENSE file or the website
+ * http://www.opensource.org/licenses/BSD-2-Clause
+ */
+
+#include "matrix.hpp"
+
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+
+//! @brief Tolerance for the comparisons to the identity.
+#define EPSILON 1e-4
+
+/**
+ * @brief Whether the given matrix is the identity, up to \link EPSILON \endlink.
+ */
+template <typename Value>
+bool isIdentity(const Matrix<Value,4,4> &m) {
+    for (unsigned int l = 0 ; l < 4 ; ++l)
+        for (unsigned int c = 0 ; c < 4 ; ++c)
+            if (fabs(m(l,c) - (l == c ? 1 : 0)) > EPSILON) return false;
+    return true;
+}
+
+/**
+ * @brief Returns a random value in [-range;+range].
+ */
+float randomValue(float range) {
+    return (rand() / (float)RAND_MAX * 2 - 1) * range;
+}
+
+/**
+ * @brief Executes unit tests for the inverses of the Matrix library.
+ */
+int main() {
+    srand(42);
+
+    for (unsigned int run = 0 ; run < 1000 ; ++run) {
+        float axis_values[4] = { randomValue(1), randomValue(1), randomValue(1), 1 };
+        Matrix<float,4,1> axis;
+        axis.take(axis_values);
+        Matrix<float,4,4> rigid = MatrixHelper::rotation(randomValue(M_PI), axis);
+        for (unsigned int i = 0 ; i < 3 ; ++i)
+            rigid(i,3) = randomValue(10);
+
+        // Rigid transformation, detected or declared
+        assert(MatrixHelper::isOrthonormal(rigid));
+        assert(isIdentity(MatrixHelper::affineInverse(rigid) * rigid));
+        assert(isIdentity(rigid * MatrixHelper::affineInverse(rigid, true)));
+        Matrix<float,4,4> rigidNormal = MatrixHelper::normalMatrix(rigid);
+        for (unsigned int l = 0 ; l < 3 ; ++l)
+            for (unsigned int c = 0 ; c < 3 ; ++c)
+                assert(rigidNormal(l,c) == rigid(l,c));
+
+        // Scaled affine transformation
+        Matrix<float,4,4> scaled = rigid;
+        for (unsigned int l = 0 ; l < 3 ; ++l)
+            scaled(l,1) *= 3;
+        assert(!MatrixHelper::isOrthonormal(scaled));
+        assert(isIdentity(MatrixHelper::affineInverse(scaled) * scaled));
+        // The normal matrix keeps the normals orthogonal to the transformed tangents
+        Matrix<float,4,4> normal = MatrixHelper::normalMatrix(scaled);
+        Matrix<float,4,1> n = normal * MatrixHelper::unitAxisVector<float>(2);
+        for (unsigned int t = 0 ; t < 2 ; ++t) {
+            float dot = 0;
+            for (unsigned int i = 0 ; i < 3 ; ++i) dot += n[i] * scaled(i,t);
+            assert(fabs(dot) < EPSILON);
+        }
+
+        // General matrices, kept well-conditioned by a dominant diagonal
+        Matrix<float,4,4> any;
+        Matrix<double,4,4> anyDouble;
+        for (unsigned int i = 0 ; i < 16 ; ++i)
+            anyDouble[i] = any[i] = randomValue(10) + (i % 5 == 0 ? 40 : 0);
+        assert(isIdentity(MatrixHelper::inverse(anyDouble) * anyDouble));
+        Matrix<float,4,4> anyInverse = MatrixHelper::inverse(any);
+        Matrix<double,4,4> anyInverseDouble = MatrixHelper::inverse(anyDouble);
+        for (unsigned int i = 0 ; i < 16 ; ++i)
+            assert(fabs(anyInverse[i] - anyInverseDouble[i]) <= EPSILON * (1 + fabs(anyInverseDouble[i])));
+        assert(isIdentity(MatrixHelper::inverse(scaled) * scaled));
+
+        // Viewing transformations are rigid, bring the eye to the origin, and look down the negative Z axis
+        Matrix<float,4,1> eye (randomValue(10), randomValue(10), randomValue(10), 1);
+        Matrix<float,4,1> center = rigid * MatrixHelper::unitAxisVector<float>(0);
+        Matrix<float,4,1> up (randomValue(1), randomValue(1), randomValue(1), 1);
+        Matrix<float,4,4> view = MatrixHelper::lookAt(eye, center, up);
+        assert(MatrixHelper::isOrthonormal(view));
+        Matrix<float,4,1> eyeInView = view * eye;
+        Matrix<float,4,1> centerInView = view * center;
+        Matrix<float,4,1> upPoint = eye + up;
+        upPoint[3] = 1;
+        Matrix<float,4,1> upInView = view * upPoint;
+        assert(fabs(eyeInView[0]) < EPSILON && fabs(eyeInView[1]) < EPSILON && fabs(eyeInView[2]) < EPSILON);
+        assert(fabs(centerInView[0]) < EPSILON * 10 && fabs(centerInView[1]) < EPSILON * 10 && centerInView[2] < 0);
+        assert(fabs(upInView[0]) < EPSILON * 10 && upInView[1] > 0);
+    }
+
+    // Perspective projections map the near and far planes to -1 and 1, and the corners of the field of view to the corners of the screen
+    Matrix<double,4,4> projection = MatrixHelper::perspective<double>(90, 2, 0.5, 10);
+    Matrix<double,4,1> nearCorner = projection * Matrix<double,4,1>(1, 0.5, -0.5, 1);
+    Matrix<double,4,1> farCorner = projection * Matrix<double,4,1>(-20, -10, -10, 1);
+    assert(fabs(nearCorner[0] / nearCorner[3] - 1) < EPSILON && fabs(nearCorner[1] / nearCorner[3] - 1) < EPSILON);
+    assert(fabs(nearCorner[2] / nearCorner[3] + 1) < EPSILON);
+    assert(fabs(farCorner[0] / farCorner[3] + 1) < EPSILON && fabs(farCorner[1] / farCorner[3] + 1) < EPSILON);
+    assert(fabs(farCorner[2] / farCorner[3] - 1) < EPSILON);
+    assert(isIdentity(MatrixHelper::inverse(projection) * projection));
+
+    // Picking a region brings its center to the center of the screen, and its corners to the corners of the screen
+    const int viewport[4] = { 10, 20, 200, 100 };
+    Matrix<double,4,4> picking = MatrixHelper::pickMatrix<double>(60, 45, 4, 2, viewport);
+    // Window coordinates (x,y) are at (2*(x-10)/200-1, 2*(y-20)/100-1) in normalized device coordinates
+    Matrix<double,4,1> center = picking * Matrix<double,4,1>(-0.5, -0.5, 0, 1);
+    Matrix<double,4,1> corner = picking * Matrix<double,4,1>(-0.48, -0.48, 0, 1);
+    assert(fabs(center[0]) < EPSILON && fabs(center[1]) < EPSILON);
+    assert(fabs(corner[0] - 1) < EPSILON && fabs(corner[1] - 1) < EPSILON);
+
+    return 0;
+}
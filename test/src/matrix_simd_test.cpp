@@ -0,0 +1,143 @@
+/**
+ * @file matrix_simd_test.cpp
+ *
+ * @brief Unit tests for the SIMD specializations of the matrix library.
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2011 Olivier Favre
+ *
+ * This file is part of Breach.
+ *
+ * Licensed under the Simplified BSD License,
+ * for details please see LICENSE file or the website
+ * http://www.opensource.org/licenses/BSD-2-Clause
+ */
+
+#include "matrix.hpp"
+
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+
+//! @brief Maximum tolerated distance between the scalar and the SIMD paths, in ULP of the accumulated magnitude, as documented in matrix.hpp.
+#define MAX_ULP 4
+
+/**
+ * @brief Returns the distance between \a x and the next representable float, away from zero.
+ */
+float ulp(float x) {
+    x = fabsf(x);
+    return nextafterf(x, INFINITY) - x;
+}
+
+/**
+ * @brief Whether \a a and \a b are within the documented tolerance.
+ *
+ * @param magnitude The sum of the absolute values of the products accumulated to obtain \a a and \a b.
+ */
+bool withinTolerance(float a, float b, float magnitude) {
+    return fabsf(a - b) <= MAX_ULP * ulp(magnitude);
+}
+
+/**
+ * @brief Returns a copy of \a m with each value replaced by its absolute value.
+ */
+template <unsigned int cols>
+Matrix<float,4,cols> absolute(Matrix<float,4,cols> m) {
+    for (unsigned int i = 0 ; i < 4*cols ; ++i) m[i] = fabsf(m[i]);
+    return m;
+}
+
+/**
+ * @brief Returns a random value in [-range;+range].
+ */
+float randomValue(float range) {
+    return (rand() / (float)RAND_MAX * 2 - 1) * range;
+}
+
+/**
+ * @brief Reproduces the generic matrix product, used as a reference.
+ */
+template <unsigned int finalCols>
+Matrix<float,4,finalCols> scalarProduct(const Matrix<float,4,4> &a, const Matrix<float,4,finalCols> &b) {
+    Matrix<float,4,finalCols> rtn;
+    rtn.fill(0);
+    for (unsigned int l = 4-1 ; ; --l) {
+        for (unsigned int c = finalCols-1 ; ; --c) {
+            for (unsigned int i = 4-1 ; ; --i) {
+                rtn(l,c) += a(l,i) * b(i,c);
+                if (i == 0) break;
+            }
+            if (c == 0) break;
+        }
+        if (l == 0) break;
+    }
+    return rtn;
+}
+
+/**
+ * @brief Executes unit tests for the SIMD specializations of the Matrix library.
+ */
+int main() {
+    srand(42);
+
+    // Known product: translation then scaling
+    {
+        float t_values[16] = { 1,0,0,0, 0,1,0,0, 0,0,1,0, 1,2,3,1 };
+        float s_values[16] = { 2,0,0,0, 0,3,0,0, 0,0,4,0, 0,0,0,1 };
+        float p_values[4] = { 1, 1, 1, 1 };
+        Matrix<float,4,4> t, s;
+        Matrix<float,4,1> p;
+        t.take(t_values);
+        s.take(s_values);
+        p.take(p_values);
+        Matrix<float,4,4> st = s * t;
+        assert(st(0,0) == 2 && st(1,1) == 3 && st(2,2) == 4 && st(3,3) == 1);
+        assert(st(0,3) == 2 && st(1,3) == 6 && st(2,3) == 12);
+        assert(st(3,0) == 0 && st(0,1) == 0 && st(1,0) == 0);
+        Matrix<float,4,1> stp = st * p;
+        assert(stp[0] == 4 && stp[1] == 9 && stp[2] == 16 && stp[3] == 1);
+    }
+
+    // Known cross product: X * Y = Z
+    {
+        Matrix<float,4,1> z = MatrixHelper::unitAxisVector<float>(0) * MatrixHelper::unitAxisVector<float>(1);
+        assert(z[0] == 0 && z[1] == 0 && z[2] == 1 && z[3] == 1);
+    }
+
+    // Random products against the scalar reference
+    for (unsigned int run = 0 ; run < 1000 ; ++run) {
+        Matrix<float,4,4> a, b;
+        Matrix<float,4,1> u, v;
+        for (unsigned int i = 0 ; i < 16 ; ++i) {
+            a[i] = randomValue(100);
+            b[i] = randomValue(100);
+        }
+        for (unsigned int i = 0 ; i < 4 ; ++i) {
+            u[i] = randomValue(100);
+            v[i] = randomValue(100);
+        }
+
+        Matrix<float,4,4> ab = a * b;
+        Matrix<float,4,4> abRef = scalarProduct(a, b);
+        Matrix<float,4,4> abMagnitude = scalarProduct(absolute(a), absolute(b));
+        for (unsigned int i = 0 ; i < 16 ; ++i)
+            assert(withinTolerance(ab[i], abRef[i], abMagnitude[i]));
+
+        Matrix<float,4,1> au = a * u;
+        Matrix<float,4,1> auRef = scalarProduct(a, u);
+        Matrix<float,4,1> auMagnitude = scalarProduct(absolute(a), absolute(u));
+        for (unsigned int i = 0 ; i < 4 ; ++i)
+            assert(withinTolerance(au[i], auRef[i], auMagnitude[i]));
+
+        Matrix<float,4,1> uv = u * v;
+        float uvRef[3] = { u[1]*v[2]-u[2]*v[1], u[2]*v[0]-u[0]*v[2], u[0]*v[1]-u[1]*v[0] };
+        float uvMagnitude[3] = { fabsf(u[1]*v[2])+fabsf(u[2]*v[1]), fabsf(u[2]*v[0])+fabsf(u[0]*v[2]), fabsf(u[0]*v[1])+fabsf(u[1]*v[0]) };
+        for (unsigned int i = 0 ; i < 3 ; ++i)
+            assert(withinTolerance(uv[i], uvRef[i], uvMagnitude[i]));
+        assert(uv[3] == 1);
+    }
+
+    return 0;
+}
@@ -0,0 +1,89 @@
+/**
+ * @file quaternion_test.cpp
+ *
+ * @brief Unit tests for the quaternions of the matrix library.
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2011 Olivier Favre
+ *
+ * This file is part of Breach.
+ *
+ * Licensed under the Simplified BSD License,
+ * for details please see LICENSE file or the website
+ * http://www.opensource.org/licenses/BSD-2-Clause
+ */
+
+#include "matrix.hpp"
+
+#include <cassert>
+#include <cmath>
+
+//! @brief Tolerance for comparisons involving trigonometry.
+#define EPSILON 1e-5
+
+/**
+ * @brief Whether both matrices are equal, up to \link EPSILON \endlink.
+ */
+template <unsigned int lines, unsigned int cols>
+bool near(const Matrix<float,lines,cols> &a, const Matrix<float,lines,cols> &b) {
+    for (unsigned int i = 0 ; i < lines*cols ; ++i)
+        if (fabs(a[i] - b[i]) > EPSILON) return false;
+    return true;
+}
+
+/**
+ * @brief Executes unit tests for the Quaternion class.
+ */
+int main() {
+    float axis_values[4] = { 1, -2, 3, 1 };
+    float vector_values[4] = { .5f, 4, -1, 1 };
+    Matrix<float,4,1> axis, vector;
+    axis.take(axis_values);
+    vector.take(vector_values);
+
+    // Identity
+    {
+        Quaternion<float> q = Quaternion<float>::identity();
+        assert(near(q.rotate(vector), vector));
+        assert(near(q.toMatrix(), MatrixHelper::identity<float>()));
+    }
+
+    // Same rotation as the matrix version
+    for (double angle = -M_PI ; angle <= M_PI ; angle += .3) {
+        Quaternion<float> q = Quaternion<float>::fromAxisAngle(angle, axis);
+        Matrix<float,4,4> rot = MatrixHelper::rotation(angle, axis);
+        assert(near(q.toMatrix(), rot));
+        assert(near(q.rotate(vector), rot * vector));
+        assert(near(q.conjugate().rotate(q.rotate(vector)), vector));
+    }
+
+    // Composition, applying the right operand first
+    {
+        Quaternion<float> qx = Quaternion<float>::fromAxisAngle(.7, MatrixHelper::unitAxisVector<float>(0));
+        Quaternion<float> qy = Quaternion<float>::fromAxisAngle(-1.2, MatrixHelper::unitAxisVector<float>(1));
+        Matrix<float,4,4> rx = MatrixHelper::rotation(.7, MatrixHelper::unitAxisVector<float>(0));
+        Matrix<float,4,4> ry = MatrixHelper::rotation(-1.2, MatrixHelper::unitAxisVector<float>(1));
+        assert(near((qy * qx).toMatrix(), ry * rx));
+        assert(near((qy * qx).rotate(vector), qy.rotate(qx.rotate(vector))));
+    }
+
+    // Many small compositions stay a pure rotation
+    {
+        Quaternion<float> q = Quaternion<float>::identity();
+        Quaternion<float> step = Quaternion<float>::fromAxisAngle(.001, axis);
+        for (unsigned int i = 0 ; i < 100000 ; ++i) {
+            q = q * step;
+            q.normalize();
+        }
+        assert(fabs(q.w*q.w + q.x*q.x + q.y*q.y + q.z*q.z - 1) < EPSILON);
+        Matrix<float,4,1> x = q.rotate(MatrixHelper::unitAxisVector<float>(0));
+        Matrix<float,4,1> y = q.rotate(MatrixHelper::unitAxisVector<float>(1));
+        x[3] = y[3] = 0;
+        assert(fabs(x.norm() - 1) < EPSILON);
+        assert(fabs(y.norm() - 1) < EPSILON);
+        assert(fabs(x[0]*y[0] + x[1]*y[1] + x[2]*y[2]) < EPSILON);
+    }
+
+    return 0;
+}
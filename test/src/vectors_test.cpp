@@ -0,0 +1,93 @@
+/**
+ * @file vectors_test.cpp
+ *
+ * @brief Unit tests for the 3D and 4D vectors.
+ *
+ * @section LICENSE
+ *
+ * Copyright (c) 2011 Olivier Favre
+ *
+ * This file is part of Breach.
+ *
+ * Licensed under the Simplified BSD License,
+ * for details please see LICENSE file or the website
+ * http://www.opensource.org/licenses/BSD-2-Clause
+ */
+
+#include "vectors.hpp"
+
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+
+/**
+ * @brief Tells whether two values are equal, within a few ULP of the given magnitude.
+ */
+bool withinTolerance(float a, float b, float magnitude) {
+    return std::fabs(a - b) <= 4 * std::numeric_limits<float>::epsilon() * magnitude;
+}
+
+/**
+ * @brief Executes unit tests for the 3D and 4D vectors.
+ */
+int main() {
+    // Lossless conversions
+    {
+        Matrix<float,4,1> m (1.5f, -2.25f, 3.125f, 1);
+        Vec3f v3 (m);
+        assert(v3.x() == 1.5f && v3.y() == -2.25f && v3.z() == 3.125f);
+        Matrix<float,4,1> back3 = v3.toMatrix();
+        for (unsigned int i = 0 ; i < 4 ; ++i)
+            assert(back3[i] == m[i]);
+        Matrix<float,4,1> n (1.5f, -2.25f, 3.125f, -7.5f);
+        Matrix<float,4,1> back4 = Vec4f(n).toMatrix();
+        for (unsigned int i = 0 ; i < 4 ; ++i)
+            assert(back4[i] == n[i]);
+    }
+
+    // Arithmetic
+    {
+        Vec4f a (1, 2, 3, 4);
+        Vec4f b (10, 20, 30, 40);
+        Vec4f c = (b - a) * 2 + (-a) / 2;
+        assert(c.x() == 17.5f && c.y() == 35 && c.z() == 52.5f && c.w() == 70);
+        assert(dot(a, b) == 300);
+        assert(length(Vec4f(1, 2, 2, 4)) == 5);
+        assert(length(Vec3f(2, 3, 6)) == 7);
+        Vec4f mid = lerp(a, b, .5f);
+        assert(mid.x() == 5.5f && mid.w() == 22);
+        Vec3f start = lerp(Vec3f(1, 2, 3), Vec3f(4, 5, 6), 0);
+        assert(start.x() == 1 && start.y() == 2 && start.z() == 3);
+    }
+
+    // Same products as the Matrix library, on random vectors
+    srand(42);
+    for (unsigned int n = 0 ; n < 1000 ; ++n) {
+        Matrix<float,4,1> u, v;
+        for (unsigned int i = 0 ; i < 3 ; ++i) {
+            u[i] = rand() / (float)RAND_MAX * 2 - 1;
+            v[i] = rand() / (float)RAND_MAX * 2 - 1;
+        }
+        u[3] = v[3] = 1;
+
+        float expectedDot = (u[0]*v[0] + u[1]*v[1]) + u[2]*v[2];
+        float magnitude = std::fabs(u[0]*v[0]) + std::fabs(u[1]*v[1]) + std::fabs(u[2]*v[2]);
+        assert(withinTolerance(dot(Vec3f(u), Vec3f(v)), expectedDot, magnitude));
+
+        Matrix<float,4,1> expectedCross = u * v;
+        Matrix<float,4,1> actualCross = cross(Vec3f(u), Vec3f(v)).toMatrix();
+        for (unsigned int i = 0 ; i < 3 ; ++i)
+            assert(withinTolerance(actualCross[i], expectedCross[i], 2));
+        assert(actualCross[3] == 1);
+
+        Vec3f normalized = normalize(Vec3f(u));
+        assert(withinTolerance(length(normalized), 1, 1));
+        Matrix<float,4,1> expectedNormalized = u / u.norm();
+        assert(withinTolerance(normalized.x(), expectedNormalized[0], 1));
+        assert(withinTolerance(normalized.y(), expectedNormalized[1], 1));
+        assert(withinTolerance(normalized.z(), expectedNormalized[2], 1));
+        assert(withinTolerance(length(normalize(Vec4f(u))), 1, 1));
+    }
+
+    return 0;
+}